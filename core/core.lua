@@ -90,3 +90,90 @@ project "core"
 
    filter "files:shaders/**"
       buildaction "None"
+
+-- static library doesn't pass its dependencies to app, call it in app project
+function linkCoreHeadless()
+   defines { "PBE_HEADLESS" }
+
+   libdirs {
+      libsinfo.physx.libDir,
+      libsinfo.blast.libDir,
+   }
+
+   links { "coreHeadless", "imgui", "yaml", "optick", "NvBlastTk", "NvBlastExtShaders" }
+
+   filter "system:windows"
+      links {
+         "PhysX_64",
+         "PhysXCommon_64",
+         "PhysXExtensions_static_64",
+         "PhysXFoundation_64",
+         "PhysXPvdSDK_static_64",
+      }
+
+      postbuildcommands {
+         '{COPY} "%{libsinfo.physx.libDir}/*.dll" "%{cfg.targetdir}"',
+         '{COPY} "%{libsinfo.blast.libDir}/*.dll" "%{cfg.targetdir}"',
+      }
+
+   filter "system:linux"
+      links {
+         "PhysXExtensions_static_64",
+         "PhysX_static_64",
+         "PhysXPvdSDK_static_64",
+         "PhysXCommon_static_64",
+         "PhysXFoundation_static_64",
+         "pthread",
+         "dl",
+      }
+      vectorextensions "AVX2"
+
+   filter { "system:linux", "configurations:Debug" }
+      defines { "_DEBUG" }
+
+   filter {}
+end
+
+-- core without renderer, window and d3d12. Scene, physics, scripts and serialization
+-- for simulation servers and benchmarks on machines without gpu
+project "coreHeadless"
+   staticCppLib()
+
+   pchheader "pch.h"
+   pchsource "src/pch.cpp"
+
+   includedirs {
+      libsinfo.core.includedirs,
+      "%{libsinfo.blast.includepath}/shared/NvFoundation",
+      "%{libsinfo.blast.includepath}/globals",
+      "%{libsinfo.blast.includepath}/lowlevel",
+      "%{libsinfo.blast.includepath}/toolkit",
+      "%{libsinfo.blast.includepath}/extensions/shaders",
+   }
+
+   filter "system:linux"
+      -- msvc enables avx intrinsics without flag, bvh8 traversal uses them
+      vectorextensions "AVX2"
+
+   -- blast and physx headers expect msvc debug define
+   filter { "system:linux", "configurations:Debug" }
+      defines { "_DEBUG" }
+
+   filter {}
+
+   defines { "PBE_HEADLESS" }
+
+   files {
+      "src/pch.h", "src/pch.cpp", "src/pchDefault.h",
+      "src/app/**", "src/core/**", "src/fs/**", "src/math/**", "src/physics/**",
+      "src/scene/**", "src/script/**", "src/typer/**", "src/utils/**",
+      "src/gui/Gui.*",
+      -- cpu only parts of renderer
+      "src/rend/BVH.*", "src/rend/BVHTracer.*", "src/rend/RefPathTracer.*",
+      "src/rend/DbgRend.*", "src/rend/DefaultVertex.h",
+      "shaders/shared/**",
+   }
+   removefiles { "src/app/Window.*", "src/fs/FileWatch.h" }
+
+   filter "files:shaders/**"
+      buildaction "None"
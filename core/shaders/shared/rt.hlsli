@@ -25,6 +25,19 @@ struct BVHNode {
    uint   secondChildOffset;
 };
 
+// 4 wide bvh node with SoA child bounds. Child is inner node idx, leaf (objIdx | BVH_WIDE_LEAF) or UINT_MAX for empty lane
+#define BVH_WIDE_LEAF 0x80000000
+
+struct BVH4Node {
+   float4 minX;
+   float4 minY;
+   float4 minZ;
+   float4 maxX;
+   float4 maxY;
+   float4 maxZ;
+   uint4  children;
+};
+
 struct SRTImportanceVolume {
    float3 position;
    float radius;
@@ -2,20 +2,27 @@
 #include "Application.h"
 
 #include "Input.h"
+#include "SimulationLayer.h"
 #include "core/Common.h"
 #include "core/Log.h"
 #include "core/Profiler.h"
-#include "rend/Device.h"
-#include "rend/CommandList.h"
-#include "Window.h"
 #include "core/CVar.h"
+#include "core/JobSystem.h"
+#include "core/MemoryTracker.h"
 #include "core/Thread.h"
-#include "gui/ImGuiLayer.h"
 #include "physics/Phys.h"
-#include "rend/CommandQueue.h"
-#include "rend/RendRes.h"
-#include "rend/Shader.h"
 #include "typer/Typer.h"
+#include "utils/Memory.h"
+
+#ifndef PBE_HEADLESS
+   #include "Window.h"
+   #include "gui/ImGuiLayer.h"
+   #include "rend/CommandList.h"
+   #include "rend/CommandQueue.h"
+   #include "rend/Device.h"
+   #include "rend/RendRes.h"
+   #include "rend/Shader.h"
+#endif
 
 
 namespace pbe {
@@ -32,50 +39,78 @@ namespace pbe {
    void Application::OnInit() {
       Typer::Get().Finalize();
 
-      Log::Init();
-
-      new Window(Window::Desc {
-         .size = { 1280, 800 },
-      });
-
-      new Device();
-      if (!sDevice->created) {
+      if (!IsHeadless() && !InitRender()) {
          return;
       }
 
       InitPhysics();
 
-      rendres::Init();
-
       Profiler::Init();
-
-      sWindow->eventCallback = [&](Event& event) { OnEvent(event); };
-
-      ImGui::CreateContext();
-
-      imguiLayer = new ImGuiLayer();
-      PushOverlay(imguiLayer);
-
-      INFO("App init success");
+      JobSystem::Init();
+
+#ifdef PBE_MEMORY_TRACKING
+      // allocations per frame of subsystems that run every frame, load time tags have no budget
+      MemoryTracker::SetFrameBudget(MemoryTag::Scene, 256);
+      MemoryTracker::SetFrameBudget(MemoryTag::Script, 256);
+      MemoryTracker::SetFrameBudget(MemoryTag::Physics, 128);
+      MemoryTracker::SetFrameBudget(MemoryTag::Render, 512);
+      MemoryTracker::SetFrameBudget(MemoryTag::DbgRend, 64);
+#endif
+
+      if (IsHeadless()) {
+         if (!headless.scenePath.empty()) {
+            PushLayer(new SimulationLayer(headless.scenePath));
+         }
+         INFO("App init success, headless dt {} frames {}", headless.dt, headless.nFrames);
+      } else {
+         INFO("App init success");
+      }
       running = true;
    }
 
    void Application::OnTerm() {
-      sDevice->Flush();
-
-      rendres::Term();
-      TermGpuPrograms();
+      if (!IsHeadless()) {
+         TermRender();
+      }
 
       TermPhysics();
 
       layerStack.Clear();
 
-      ImGui::DestroyContext();
+      if (!IsHeadless()) {
+         ImGui::DestroyContext();
+      }
 
+      JobSystem::Term();
       Profiler::Term();
 
+#ifndef PBE_HEADLESS
       SAFE_DELETE(sDevice);
       SAFE_DELETE(sWindow);
+#endif
+   }
+
+   void Application::ParseArgs(int nArgs, char** args) {
+      for (int i = 1; i < nArgs; ++i) {
+         std::string_view arg = args[i];
+         bool hasValue = i + 1 < nArgs;
+
+         if (arg == "-headless") {
+            headless.enabled = true;
+         } else if (arg == "-frames" && hasValue) {
+            headless.nFrames = (u32)std::stoul(args[++i]);
+         } else if (arg == "-dt" && hasValue) {
+            headless.dt = std::stof(args[++i]);
+         } else if (arg == "-scene" && hasValue) {
+            headless.scenePath = args[++i];
+         } else {
+            WARN("Unknown argument '{}'", arg);
+         }
+      }
+
+#ifdef PBE_HEADLESS
+      headless.enabled = true;
+#endif
    }
 
    void Application::OnEvent(Event& event) {
@@ -92,6 +127,7 @@ namespace pbe {
          focused = true;
       }
 
+#ifndef PBE_HEADLESS
       if (auto* windowResize = event.GetEvent<WindowResizeEvent>()) {
          sDevice->Resize(windowResize->size);
       }
@@ -102,6 +138,7 @@ namespace pbe {
             event.handled = true;
          }
       }
+#endif
 
       if (!event.handled) {
          for (auto it = layerStack.end(); it != layerStack.begin();) {
@@ -145,12 +182,8 @@ namespace pbe {
             // ThreadSleepMs(250);
          }
 
-         {
-            OPTICK_EVENT("Window Update");
-            PIX_EVENT_SYSTEM(Window, "Window Update");
-            Input::ClearKeys();
-            sWindow->Update();
-            Input::NextFrame();
+         if (!IsHeadless()) {
+            UpdateWindow();
 
             // todo:
             if (!running) {
@@ -175,57 +208,29 @@ namespace pbe {
          if (dt > 1.f) {
             dt = 1.f / 60.f;
          }
+         // simulation must not depend on speed of machine
+         if (IsHeadless()) {
+            dt = headless.dt;
+         }
          OPTICK_TAG("DeltaTime (ms)", dt * 1000.f);
 
          // todo: different interface
          sConfigVarsMng.NextFrame(); // todo: use before triggered in that frame
          Profiler::Get().NextFrame();
-         ShadersSrcWatcherUpdate();
+         FrameArena::NextFrame();
 
          for (auto* layer : layerStack) {
             layer->OnUpdate(dt);
          }
 
-         {
-            OPTICK_EVENT("OnImGuiRender");
-            PROFILE_CPU("OnImGuiRender");
-
-            imguiLayer->NewFrame();
-
-            for (auto* layer : layerStack) {
-               layer->OnImGuiRender();
-            }
-
-            imguiLayer->EndFrame();
+         if (!IsHeadless()) {
+            RenderFrame();
          }
 
-         {
-            CommandQueue& commandQueue = sDevice->GetCommandQueue();
-            CommandList& cmd = commandQueue.GetCommandList();
-
-            {
-               OPTICK_EVENT("ImGui Render");
-               COMMAND_LIST_SCOPE(cmd, "ImGui Render");
-
-               PIX_EVENT_SYSTEM(UI, "ImGui Render");
-
-               Texture2D& backBuffer = sDevice->WaitBackBuffer();
-
-               vec4 clearColor = { 0.45f, 0.55f, 0.60f, 1.00f };
-               cmd.ClearRenderTarget(backBuffer, clearColor);
-
-               cmd.SetRenderTarget(&backBuffer);
-               imguiLayer->Render(cmd);
-
-               cmd.TransitionBarrier(backBuffer, D3D12_RESOURCE_STATE_PRESENT);
-            }
-
-            commandQueue.Execute(cmd);
-         }
-
-         {
-            OPTICK_EVENT("Present");
-            sDevice->Present();
+         ++frameIdx;
+         if (IsHeadless() && headless.nFrames > 0 && frameIdx >= headless.nFrames) {
+            INFO("Headless run finished, {} frames", frameIdx);
+            running = false;
          }
       }
 
@@ -246,4 +251,96 @@ namespace pbe {
       #endif
    }
 
+#ifndef PBE_HEADLESS
+   bool Application::InitRender() {
+      new Window(Window::Desc {
+         .size = { 1280, 800 },
+      });
+
+      new Device();
+      if (!sDevice->created) {
+         return false;
+      }
+
+      rendres::Init();
+
+      sWindow->eventCallback = [&](Event& event) { OnEvent(event); };
+
+      ImGui::CreateContext();
+
+      imguiLayer = new ImGuiLayer();
+      PushOverlay(imguiLayer);
+
+      return true;
+   }
+
+   void Application::TermRender() {
+      sDevice->Flush();
+
+      rendres::Term();
+      TermGpuPrograms();
+   }
+
+   void Application::UpdateWindow() {
+      {
+         OPTICK_EVENT("Window Update");
+         PIX_EVENT_SYSTEM(Window, "Window Update");
+         Input::ClearKeys();
+         sWindow->Update();
+         Input::NextFrame();
+      }
+
+      ShadersSrcWatcherUpdate();
+   }
+
+   void Application::RenderFrame() {
+      {
+         OPTICK_EVENT("OnImGuiRender");
+         PROFILE_CPU("OnImGuiRender");
+
+         imguiLayer->NewFrame();
+
+         for (auto* layer : layerStack) {
+            layer->OnImGuiRender();
+         }
+
+         imguiLayer->EndFrame();
+      }
+
+      {
+         CommandQueue& commandQueue = sDevice->GetCommandQueue();
+         CommandList& cmd = commandQueue.GetCommandList();
+
+         {
+            OPTICK_EVENT("ImGui Render");
+            COMMAND_LIST_SCOPE(cmd, "ImGui Render");
+
+            PIX_EVENT_SYSTEM(UI, "ImGui Render");
+
+            Texture2D& backBuffer = sDevice->WaitBackBuffer();
+
+            vec4 clearColor = { 0.45f, 0.55f, 0.60f, 1.00f };
+            cmd.ClearRenderTarget(backBuffer, clearColor);
+
+            cmd.SetRenderTarget(&backBuffer);
+            imguiLayer->Render(cmd);
+
+            cmd.TransitionBarrier(backBuffer, D3D12_RESOURCE_STATE_PRESENT);
+         }
+
+         commandQueue.Execute(cmd);
+      }
+
+      {
+         OPTICK_EVENT("Present");
+         sDevice->Present();
+      }
+   }
+#else
+   bool Application::InitRender() { return false; }
+   void Application::TermRender() {}
+   void Application::UpdateWindow() {}
+   void Application::RenderFrame() {}
+#endif
+
 }
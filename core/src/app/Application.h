@@ -21,15 +21,42 @@ namespace pbe {
       void PushOverlay(Layer* overlay);
 
       void Run();
+      void Quit() { running = false; }
 
       const char* GetBuildType();
 
+      // no window, device and imgui. Layers are updated with fixed dt as fast as possible
+      struct HeadlessDesc {
+#ifdef PBE_HEADLESS
+         bool enabled = true;
+#else
+         bool enabled = false;
+#endif
+         float dt = 1.f / 60.f;
+         u32 nFrames = 0; // 0 - until Quit
+         string scenePath; // simulated by SimulationLayer if set
+      };
+
+      // -headless -frames <n> -dt <seconds> -scene <path>
+      virtual void ParseArgs(int nArgs, char** args);
+
+      bool IsHeadless() const { return headless.enabled; }
+      u64 GetFrameIdx() const { return frameIdx; }
+
+      HeadlessDesc headless;
+
    private:
       bool running = false;
       LayerStack layerStack;
       ImGuiLayer* imguiLayer{};
 
       bool focused = true;
+      u64 frameIdx = 0;
+
+      bool InitRender();
+      void TermRender();
+      void UpdateWindow();
+      void RenderFrame();
    };
 
    extern CORE_API Application* sApplication;
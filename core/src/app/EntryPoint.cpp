@@ -1,13 +1,22 @@
 #include "pch.h"
 #include "EntryPoint.h"
 
+#include "core/Log.h"
 
-int pbeMain(pbe::Application* sApplication, int nArgs, char** args) {
 
-   sApplication->OnInit();
-   sApplication->Run();
-   sApplication->OnTerm();
-   delete sApplication;
+int pbeMain(pbe::Application* app, int nArgs, char** args) {
+   pbe::sApplication = app;
+
+   // before args, they may report errors
+   pbe::Log::Init();
+
+   app->ParseArgs(nArgs, args);
+   app->OnInit();
+   app->Run();
+   app->OnTerm();
+
+   delete app;
+   pbe::sApplication = nullptr;
 
    return 0;
 }
@@ -1,4 +1,9 @@
 #include "core/Core.h"
 #include "Application.h"
 
-CORE_API int pbeMain(pbe::Application * sApplication, int nArgs, char** args);
+// app module has its own operator new, core dll hooks only its allocations
+#if !defined(PBE_HEADLESS) && !defined(CORE_API_EXPORT)
+   #include "core/MemoryHook.h"
+#endif
+
+CORE_API int pbeMain(pbe::Application* app, int nArgs, char** args);
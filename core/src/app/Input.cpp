@@ -2,7 +2,6 @@
 #include "Input.h"
 
 #include "Event.h"
-#include "Window.h"
 #include "core/Log.h"
 
 
@@ -10,14 +9,23 @@ namespace pbe {
 
    static Input sInput;
 
+   // headless app has no cursor, mouse stays at zero
    static int2 GetGlobalMousePosition() {
+#ifndef PBE_HEADLESS
       POINT p;
       if (GetCursorPos(&p)) {
          return { p.x, p.y };
       }
+#endif
       return {};
    }
 
+   static void SetGlobalMousePosition(int2 pos) {
+#ifndef PBE_HEADLESS
+      SetCursorPos(pos.x, pos.y);
+#endif
+   }
+
    Input::Input() {
       int size = 256; // todo:
       keyDown.resize(size);
@@ -37,7 +45,7 @@ namespace pbe {
 
    void Input::SetMousePosition(int2 pos) {
       sInput.mousePos = pos;
-      SetCursorPos(pos.x, pos.y);
+      SetGlobalMousePosition(pos);
    }
 
    void Input::LockMousePos(bool lock) {
@@ -45,7 +53,9 @@ namespace pbe {
    }
 
    void Input::HideMouse(bool lock) {
+#ifndef PBE_HEADLESS
       while (ShowCursor(FALSE) > 0) {}
+#endif
       if (lock) {
          LockMousePos(true);
       }
@@ -55,7 +65,9 @@ namespace pbe {
       if (unlock) {
          LockMousePos(false);
       }
+#ifndef PBE_HEADLESS
       while (ShowCursor(TRUE) < 0) {}
+#endif
    }
 
    bool Input::IsKeyDown(KeyCode keyCode) {
@@ -82,14 +94,14 @@ namespace pbe {
    }
 
    void Input::ClearKeys() {
-      std::ranges::fill(sInput.keyDown, false);
-      std::ranges::fill(sInput.keyUp, false);
+      std::fill(sInput.keyDown.begin(), sInput.keyDown.end(), false);
+      std::fill(sInput.keyUp.begin(), sInput.keyUp.end(), false);
    }
 
    void Input::NextFrame() {
       sInput.mouseDelta = GetGlobalMousePosition() - sInput.mousePos;
       if (sInput.mouseLocked) {
-         SetCursorPos(sInput.mousePos.x, sInput.mousePos.y);
+         SetGlobalMousePosition(sInput.mousePos);
       } else {
          sInput.mousePos += sInput.mouseDelta;
       }
@@ -9,12 +9,12 @@ namespace pbe {
       LeftButton = 1,
       RightButton = 2,
 
-      Space = VK_SPACE,
-      Escape = VK_ESCAPE,
-      Shift = VK_SHIFT,
-      Ctrl = VK_CONTROL,
-      Alt = VK_MENU,
-      Delete = VK_DELETE,
+      Space = 0x20, // VK_SPACE
+      Escape = 0x1B, // VK_ESCAPE
+      Shift = 0x10, // VK_SHIFT
+      Ctrl = 0x11, // VK_CONTROL
+      Alt = 0x12, // VK_MENU
+      Delete = 0x2E, // VK_DELETE
 
       A = 65,
       B,
@@ -43,7 +43,7 @@ namespace pbe {
       Y,
       Z,
 
-      F1 = VK_F1,
+      F1 = 0x70, // VK_F1
       F2,
       F3,
       F4,
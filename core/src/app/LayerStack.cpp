@@ -5,7 +5,6 @@ namespace pbe {
 
    LayerStack::LayerStack() {
       // layers.reserve(2);
-      layerInsert = layers.begin();
    }
 
    LayerStack::~LayerStack() {
@@ -13,21 +12,21 @@ namespace pbe {
    }
 
    void LayerStack::PushLayer(Layer* layer) {
-      layerInsert = layers.emplace(layerInsert, layer);
+      // layers are kept in push order below overlays
+      layers.emplace(layers.begin() + layerInsertIdx++, layer);
    }
 
    void LayerStack::PushOverlay(Layer* overlay) {
       layers.emplace_back(overlay);
-      if (!layerInsert._Ptr) { // todo:
-         layerInsert = layers.begin();
-      }
    }
 
    void LayerStack::PopLayer(Layer* layer) {
       auto it = std::find(layers.begin(), layers.end(), layer);
       if (it != layers.end()) {
+         if (it - layers.begin() < layerInsertIdx) {
+            --layerInsertIdx;
+         }
          layers.erase(it);
-         --layerInsert;
       }
 
    }
@@ -45,6 +44,7 @@ namespace pbe {
       }
 
       layers.clear();
+      layerInsertIdx = 0;
    }
 
 }
@@ -24,7 +24,8 @@ namespace pbe {
       Layers::iterator end() { return layers.end(); }
    private:
       Layers layers;
-      Layers::iterator layerInsert;
+      // index, iterator is invalidated by overlays
+      u32 layerInsertIdx = 0;
    };
 
 }
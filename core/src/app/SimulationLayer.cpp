@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "SimulationLayer.h"
+
+#include "core/Log.h"
+#include "core/Profiler.h"
+#include "rend/DbgRend.h"
+#include "scene/Scene.h"
+
+
+namespace pbe {
+
+   SimulationLayer::SimulationLayer(std::string_view scenePath)
+      : Layer("SimulationLayer"), scenePath(scenePath) {
+   }
+
+   SimulationLayer::~SimulationLayer() = default;
+
+   void SimulationLayer::OnAttach() {
+      scene = SceneDeserialize(scenePath);
+      if (!scene) {
+         WARN("Simulation has no scene");
+         return;
+      }
+
+      scene->OnStart();
+      INFO("Simulate scene '{}', {} entities", scenePath, scene->EntitiesCount());
+
+      Layer::OnAttach();
+   }
+
+   void SimulationLayer::OnDetach() {
+      if (scene) {
+         scene->OnStop();
+         scene = {};
+      }
+
+      Layer::OnDetach();
+   }
+
+   void SimulationLayer::OnUpdate(float dt) {
+      if (!scene) {
+         return;
+      }
+
+      PROFILE_CPU("Simulation");
+
+      scene->OnTick();
+      scene->OnUpdate(dt);
+
+      // scripts may draw debug geometry, nobody renders it in headless mode
+      if (scene->HasSceneData<DbgRend>()) {
+         scene->GetSceneData<DbgRend>().Clear();
+      }
+   }
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Layer.h"
+#include "core/Ref.h"
+
+
+namespace pbe {
+
+   class Scene;
+
+   // loads scene and simulates it like play mode in editor, but without any rendering
+   class CORE_API SimulationLayer : public Layer {
+   public:
+      SimulationLayer(std::string_view scenePath);
+      ~SimulationLayer() override;
+
+      void OnAttach() override;
+      void OnDetach() override;
+
+      void OnUpdate(float dt) override;
+
+      Scene* GetScene() const { return scene.get(); }
+
+   private:
+      string scenePath;
+      Own<Scene> scene;
+   };
+
+}
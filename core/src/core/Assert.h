@@ -10,12 +10,16 @@
 #endif
 
 #ifdef ENABLE_ASSERTS
-   #define DEBUG_BREAK() __debugbreak()
+   #if defined(_MSC_VER)
+      #define DEBUG_BREAK() __debugbreak()
+   #else
+      #define DEBUG_BREAK() __builtin_trap()
+   #endif
 
-   #define ASSERT_MESSAGE(condition, ...) { if(!(condition)) { ERROR("Assertion Failed: {0}", __VA_ARGS__); __debugbreak(); } }
-   #define ASSERT(condition) { if(!(condition)) { ERROR("Assertion Failed"); __debugbreak(); } }
+   #define ASSERT_MESSAGE(condition, ...) { if(!(condition)) { ERROR("Assertion Failed: {0}", __VA_ARGS__); DEBUG_BREAK(); } }
+   #define ASSERT(condition) { if(!(condition)) { ERROR("Assertion Failed"); DEBUG_BREAK(); } }
 
-   #define UNIMPLEMENTED() ASSERT(FALSE)
+   #define UNIMPLEMENTED() ASSERT(false)
 #else
    #define DEBUG_BREAK()
 
@@ -79,26 +79,32 @@ namespace pbe {
       }
    }
 
+   template<>
    void CVarValue<bool>::UI() {
       ImGui::Checkbox(name.c_str(), &value);
    }
 
+   template<>
    void CVarValue<int>::UI() {
       ImGui::InputInt(name.c_str(), &value);
    }
 
+   template<>
    void CVarValue<u32>::UI() {
       ImGui::InputScalar(name.c_str(), ImGuiDataType_U32, (void*)&value, nullptr, nullptr, "%d");
    }
 
+   template<>
    void CVarValue<float>::UI() {
       ImGui::InputFloat(name.c_str(), &value);
    }
 
+   template<>
    void CVarSlider<int>::UI() {
       ImGui::SliderInt(name.c_str(), &value, min, max);
    }
 
+   template<>
    void CVarSlider<float>::UI() {
       ImGui::SliderFloat(name.c_str(), &value, min, max);
    }
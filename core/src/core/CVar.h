@@ -61,10 +61,10 @@ namespace pbe {
       T value = false;
    };
 
-   extern template void CORE_API CVarValue<bool>::UI();
-   extern template void CORE_API CVarValue<int>::UI();
-   extern template void CORE_API CVarValue<u32>::UI();
-   extern template void CORE_API CVarValue<float>::UI();
+   template<> void CORE_API CVarValue<bool>::UI();
+   template<> void CORE_API CVarValue<int>::UI();
+   template<> void CORE_API CVarValue<u32>::UI();
+   template<> void CORE_API CVarValue<float>::UI();
 
    template<typename T>
    class CVarSlider : public CVar {
@@ -83,8 +83,8 @@ namespace pbe {
       T max;
    };
 
-   extern template void CORE_API CVarSlider<int>::UI();
-   extern template void CORE_API CVarSlider<float>::UI();
+   template<> void CORE_API CVarSlider<int>::UI();
+   template<> void CORE_API CVarSlider<float>::UI();
 
    class CVarTrigger : public CVar {
    public:
@@ -10,7 +10,10 @@
 
 #define EXTERN_C extern "C"
 
-#ifdef CORE_API_EXPORT
+#if defined(PBE_HEADLESS)
+   // headless core is linked statically
+   #define CORE_API
+#elif defined(CORE_API_EXPORT)
    #define CORE_API  __declspec(dllexport)
 #else
    #define CORE_API  __declspec(dllimport)
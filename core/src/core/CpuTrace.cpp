@@ -0,0 +1,261 @@
+#include "pch.h"
+#include "CpuTrace.h"
+
+#include <chrono>
+#include <mutex>
+
+#include "Assert.h"
+#include "CVar.h"
+#include "Common.h"
+#include "Log.h"
+#include "Ref.h"
+
+
+namespace pbe {
+
+   CVarValue<bool> cvTraceEnable{ "profiler/trace/enable", true };
+   CVarValue<u32> cvTraceFrames{ "profiler/trace/frames", 60 };
+   CVarTrigger cvTraceDump{ "profiler/trace/dump" };
+
+   std::atomic<bool> CpuTrace::sEnabled = false;
+
+   struct ThreadBuffer {
+      u32 tid = 0;
+      string name;
+
+      std::unique_ptr<CpuTrace::Event[]> events{ new CpuTrace::Event[CpuTrace::ThreadCapacity] };
+      // number of events written, published after event is written
+      std::atomic<u64> head = 0;
+
+      u32 depth = 0;
+   };
+
+   struct TraceState {
+      std::mutex mutex;
+      std::vector<Own<ThreadBuffer>> threads;
+
+      u64 frames[CpuTrace::FramesCapacity] = {};
+      u64 nFrames = 0;
+
+      // ticks to time calibration
+      u64 initTicks = 0;
+      std::chrono::steady_clock::time_point initTime;
+
+      // buffers of previous Init are invalid
+      u32 generation = 0;
+   };
+
+   static TraceState* sTrace = nullptr;
+   static u32 sGeneration = 0;
+
+   static thread_local ThreadBuffer* tBuffer = nullptr;
+   static thread_local u32 tGeneration = 0;
+   static thread_local string tPendingName;
+
+   // callers check that trace is initialized
+   static ThreadBuffer& GetThreadBuffer() {
+      ASSERT(sTrace);
+      if (tBuffer && tGeneration == sTrace->generation) {
+         return *tBuffer;
+      }
+
+      std::lock_guard lock{ sTrace->mutex };
+
+      auto buffer = std::make_unique<ThreadBuffer>();
+      buffer->tid = (u32)sTrace->threads.size();
+      buffer->name = tPendingName.empty() ? "Thread " + std::to_string(buffer->tid) : tPendingName;
+
+      tBuffer = buffer.get();
+      tGeneration = sTrace->generation;
+
+      sTrace->threads.emplace_back(std::move(buffer));
+      return *tBuffer;
+   }
+
+   void CpuTrace::Init() {
+      sTrace = new TraceState();
+      sTrace->generation = ++sGeneration;
+      sTrace->initTicks = Now();
+      sTrace->initTime = std::chrono::steady_clock::now();
+
+      SetThreadName("Main");
+      SetEnabled(cvTraceEnable);
+   }
+
+   void CpuTrace::Term() {
+      SetEnabled(false);
+      SAFE_DELETE(sTrace);
+   }
+
+   void CpuTrace::SetEnabled(bool enabled) {
+      sEnabled.store(enabled && sTrace, std::memory_order_relaxed);
+   }
+
+   double CpuTrace::MsPerTick() {
+      if (!sTrace) {
+         return 0;
+      }
+
+      u64 ticks = Now() - sTrace->initTicks;
+      double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sTrace->initTime).count();
+      return ticks > 0 ? elapsedMs / double(ticks) : 0;
+   }
+
+   u64 CpuTrace::BeginScope() {
+      if (!sTrace) {
+         return Now();
+      }
+
+      ++GetThreadBuffer().depth;
+      return Now();
+   }
+
+   void CpuTrace::EndScope(std::string_view name, u64 begin, u64 end) {
+      if (!sTrace) {
+         return;
+      }
+
+      ThreadBuffer& buffer = GetThreadBuffer();
+      u32 depth = --buffer.depth;
+
+      u64 head = buffer.head.load(std::memory_order_relaxed);
+      buffer.events[head % ThreadCapacity] = Event{ name, begin, end, depth };
+      buffer.head.store(head + 1, std::memory_order_release);
+   }
+
+   void CpuTrace::SetThreadName(std::string_view name) {
+      tPendingName = name;
+      if (sTrace) {
+         std::lock_guard lock{ sTrace->mutex };
+         if (tBuffer && tGeneration == sTrace->generation) {
+            tBuffer->name = name;
+         }
+      }
+   }
+
+   void CpuTrace::NextFrame() {
+      SetEnabled(cvTraceEnable);
+      if (!sTrace) {
+         return;
+      }
+
+      {
+         std::lock_guard lock{ sTrace->mutex };
+         sTrace->frames[sTrace->nFrames % FramesCapacity] = Now();
+         ++sTrace->nFrames;
+      }
+
+      if (cvTraceDump) {
+         Dump("trace.json", cvTraceFrames);
+      }
+   }
+
+   // names are user strings, quotes and control chars would break json
+   static void WriteJsonString(std::ofstream& out, std::string_view str) {
+      out << '"';
+      for (char c : str) {
+         switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+               if ((u8)c < 0x20) {
+                  out << std::format("\\u{:04x}", (u32)(u8)c);
+               } else {
+                  out << c;
+               }
+         }
+      }
+      out << '"';
+   }
+
+   bool CpuTrace::Dump(std::string_view path, u32 nFrames) {
+      if (!sTrace) {
+         return false;
+      }
+
+      std::ofstream out{ std::string{ path } };
+      if (!out) {
+         WARN("Can't open '{}' for cpu trace", path);
+         return false;
+      }
+
+      std::lock_guard lock{ sTrace->mutex };
+
+      u64 nowTicks = Now();
+      double elapsedUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sTrace->initTime).count();
+      double usPerTick = elapsedUs > 0 ? elapsedUs / double(nowTicks - sTrace->initTicks) : 0;
+
+      auto toUs = [&](u64 ticks) {
+         return double(ticks - sTrace->initTicks) * usPerTick;
+      };
+
+      u64 nStoredFrames = std::min<u64>(sTrace->nFrames, FramesCapacity);
+      u64 minTicks = 0;
+      if (nFrames > 0 && nStoredFrames > 0) {
+         u64 firstFrame = sTrace->nFrames - std::min<u64>(nFrames, nStoredFrames);
+         minTicks = sTrace->frames[firstFrame % FramesCapacity];
+      }
+
+      out << std::fixed;
+      out.precision(3);
+      out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+      bool first = true;
+      auto separator = [&]() -> const char* {
+         bool wasFirst = first;
+         first = false;
+         return wasFirst ? "" : ",\n";
+      };
+
+      for (u64 i = sTrace->nFrames - nStoredFrames; i < sTrace->nFrames; ++i) {
+         u64 ticks = sTrace->frames[i % FramesCapacity];
+         if (ticks >= minTicks) {
+            out << separator() << R"({"name":"Frame","ph":"i","s":"g","pid":1,"tid":0,"ts":)" << toUs(ticks) << "}";
+         }
+      }
+
+      u32 nEvents = 0;
+      std::vector<Event> events;
+
+      for (const auto& thread : sTrace->threads) {
+         out << separator() << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << thread->tid << R"(,"args":{"name":)";
+         WriteJsonString(out, thread->name);
+         out << "}}";
+
+         // thread keeps writing while we copy, skip events which could be overwritten during copy
+         u64 head = thread->head.load(std::memory_order_acquire);
+         u64 begin = head > ThreadCapacity ? head - ThreadCapacity : 0;
+
+         events.clear();
+         for (u64 i = begin; i < head; ++i) {
+            events.push_back(thread->events[i % ThreadCapacity]);
+         }
+
+         u64 headAfter = thread->head.load(std::memory_order_acquire);
+         u64 firstValid = headAfter >= ThreadCapacity ? headAfter - ThreadCapacity + 1 : 0;
+
+         for (u64 i = std::max(begin, firstValid); i < head; ++i) {
+            const Event& event = events[i - begin];
+            if (event.begin < minTicks) {
+               continue;
+            }
+
+            out << separator() << R"({"name":)";
+            WriteJsonString(out, event.name);
+            out << R"(,"ph":"X","pid":1,"tid":)" << thread->tid
+               << R"(,"ts":)" << toUs(event.begin) << R"(,"dur":)" << double(event.end - event.begin) * usPerTick
+               << R"(,"args":{"depth":)" << event.depth << "}}";
+            ++nEvents;
+         }
+      }
+
+      out << "\n]}\n";
+
+      INFO("Cpu trace saved to '{}', {} events", path, nEvents);
+      return true;
+   }
+
+}
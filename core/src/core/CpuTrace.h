@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "Core.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+   #if defined(_MSC_VER)
+      #include <intrin.h>
+   #else
+      #include <x86intrin.h>
+   #endif
+   #define CPU_TRACE_RDTSC
+#endif
+
+
+namespace pbe {
+
+   // records cpu scopes of all threads to per thread ring buffers and dumps them as chrome trace json
+   // (chrome://tracing or ui.perfetto.dev). Scope costs two timestamps and one write to thread buffer,
+   // only thread itself writes to its buffer, dump reads them without stopping threads
+   class CORE_API CpuTrace {
+   public:
+      struct Event {
+         std::string_view name; // static string, PROFILE_CPU names are literals
+         u64 begin = 0; // ticks
+         u64 end = 0;
+         u32 depth = 0;
+      };
+
+      // per thread, oldest events are overwritten
+      static constexpr u32 ThreadCapacity = 1 << 15;
+      static constexpr u32 FramesCapacity = 1024;
+
+      static void Init();
+      static void Term();
+
+      static bool IsEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+      static void SetEnabled(bool enabled);
+
+      // ticks, rdtsc on x64
+      static u64 Now() {
+#ifdef CPU_TRACE_RDTSC
+         return __rdtsc();
+#else
+         return (u64)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+      }
+
+      // calibrated against steady clock since Init, 0 if not initialized
+      static double MsPerTick();
+
+      // returns begin timestamp for EndScope
+      static u64 BeginScope();
+      static void EndScope(std::string_view name, u64 begin, u64 end);
+
+      static void SetThreadName(std::string_view name);
+
+      // main thread, marks frame boundary
+      static void NextFrame();
+
+      // last nFrames frames, 0 - everything in buffers
+      static bool Dump(std::string_view path, u32 nFrames = 0);
+
+   private:
+      static std::atomic<bool> sEnabled;
+   };
+
+}
@@ -0,0 +1,211 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+#include "Assert.h"
+#include "CpuTrace.h"
+#include "Log.h"
+#include "optick.h"
+
+
+namespace pbe {
+
+   static JobSystem* sJobSystem = nullptr;
+
+   static thread_local u32 sThreadIdx = 0;
+
+   JobCounter::~JobCounter() {
+      // job that finished last may still hold the lock
+      std::lock_guard lock{ pendingMutex };
+      ASSERT(value == 0);
+   }
+
+   void JobSystem::Init(u32 nWorkers) {
+      if (nWorkers == 0) {
+         nWorkers = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+      }
+      sJobSystem = new JobSystem(nWorkers);
+      INFO("Job system: {} workers", nWorkers);
+   }
+
+   void JobSystem::Term() {
+      SAFE_DELETE(sJobSystem);
+   }
+
+   JobSystem& JobSystem::Get() {
+      return *sJobSystem;
+   }
+
+   u32 JobSystem::ThreadIdx() {
+      return sThreadIdx;
+   }
+
+   JobSystem::JobSystem(u32 nWorkers) {
+      queues.resize(nWorkers + 1);
+      for (auto& queue : queues) {
+         queue = std::make_unique<WorkerQueue>();
+      }
+
+      for (u32 i = 1; i <= nWorkers; ++i) {
+         workers.emplace_back([this, i] { WorkerLoop(i); });
+      }
+   }
+
+   JobSystem::~JobSystem() {
+      {
+         std::lock_guard lock{ sleepMutex };
+         stop = true;
+      }
+      sleepCV.notify_all();
+
+      for (auto& worker : workers) {
+         worker.join();
+      }
+   }
+
+   void JobSystem::Run(const char* name, JobFunc func, JobCounter* counter) {
+      if (counter) {
+         counter->value.fetch_add(1, std::memory_order_relaxed);
+      }
+      Push(Job{ std::move(func), name, counter });
+   }
+
+   void JobSystem::RunAfter(JobCounter& after, const char* name, JobFunc func, JobCounter* counter) {
+      if (counter) {
+         counter->value.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      Job job{ std::move(func), name, counter };
+      {
+         std::lock_guard lock{ after.pendingMutex };
+         if (!after.IsDone()) {
+            after.pending.emplace_back(std::move(job));
+            return;
+         }
+      }
+      Push(std::move(job));
+   }
+
+   void JobSystem::Wait(const JobCounter& counter) {
+      OPTICK_EVENT("Job Wait");
+
+      while (!counter.IsDone()) {
+         if (!TryRunOne()) {
+            std::this_thread::yield();
+         }
+      }
+   }
+
+   void JobSystem::ParallelFor(const char* name, u32 count, u32 batchSize,
+      const std::function<void(u32 begin, u32 end)>& func) {
+      batchSize = std::max(batchSize, 1u);
+      if (count <= batchSize || queues.size() == 1) {
+         if (count > 0) {
+            func(0, count);
+         }
+         return;
+      }
+
+      JobCounter counter;
+      for (u32 begin = 0; begin < count; begin += batchSize) {
+         u32 end = std::min(begin + batchSize, count);
+         Run(name, [&func, begin, end] { func(begin, end); }, &counter);
+      }
+      Wait(counter);
+   }
+
+   void JobSystem::Push(Job&& job) {
+      // threads not owned by job system push to main queue
+      auto& queue = *queues[sThreadIdx < queues.size() ? sThreadIdx : 0];
+      {
+         std::lock_guard lock{ queue.mutex };
+         queue.jobs.emplace_back(std::move(job));
+      }
+      nQueued.fetch_add(1, std::memory_order_release);
+
+      // lock to not miss worker that is going to sleep
+      { std::lock_guard lock{ sleepMutex }; }
+      sleepCV.notify_one();
+   }
+
+   bool JobSystem::TryPop(u32 threadIdx, Job& job) {
+      if (nQueued.load(std::memory_order_acquire) == 0) {
+         return false;
+      }
+
+      // own queue is lifo for cache locality, steal oldest jobs from others
+      u32 nQueues = (u32)queues.size();
+      for (u32 i = 0; i < nQueues; ++i) {
+         bool own = i == 0;
+         auto& queue = *queues[(threadIdx + i) % nQueues];
+
+         std::lock_guard lock{ queue.mutex };
+         if (queue.jobs.empty()) {
+            continue;
+         }
+
+         if (own) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+         } else {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+         }
+         nQueued.fetch_sub(1, std::memory_order_relaxed);
+         return true;
+      }
+
+      return false;
+   }
+
+   bool JobSystem::TryRunOne() {
+      Job job;
+      if (!TryPop(sThreadIdx, job)) {
+         return false;
+      }
+      Execute(job);
+      return true;
+   }
+
+   void JobSystem::Execute(Job& job) {
+      {
+         OPTICK_EVENT_DYNAMIC(job.name);
+         job.func();
+      }
+
+      JobCounter* counter = job.counter;
+      if (!counter) {
+         return;
+      }
+
+      std::vector<Job> pending;
+      {
+         std::lock_guard lock{ counter->pendingMutex };
+         if (counter->value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            pending = std::move(counter->pending);
+         }
+      }
+      // counter may be destroyed by waiting thread from this point
+
+      for (auto& pendingJob : pending) {
+         Push(std::move(pendingJob));
+      }
+   }
+
+   void JobSystem::WorkerLoop(u32 threadIdx) {
+      sThreadIdx = threadIdx;
+
+      std::string name = "Worker " + std::to_string(threadIdx);
+      OPTICK_THREAD(name.c_str());
+      CpuTrace::SetThreadName(name);
+
+      while (!stop) {
+         if (TryRunOne()) {
+            continue;
+         }
+
+         std::unique_lock lock{ sleepMutex };
+         sleepCV.wait(lock, [&] { return nQueued.load(std::memory_order_acquire) > 0 || stop; });
+      }
+   }
+
+}
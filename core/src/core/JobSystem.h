@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "Common.h"
+#include "Core.h"
+#include "Ref.h"
+
+
+namespace pbe {
+
+   struct JobCounter;
+
+   using JobFunc = std::function<void()>;
+
+   struct Job {
+      JobFunc func;
+      const char* name = "Job";
+      JobCounter* counter = nullptr;
+   };
+
+   // number of unfinished jobs. Jobs are added to counter on Run and removed when done.
+   // Jobs scheduled with RunAfter start only when counter is done
+   struct CORE_API JobCounter {
+      NON_COPYABLE(JobCounter);
+
+      JobCounter() = default;
+      ~JobCounter();
+
+      bool IsDone() const { return value.load(std::memory_order_acquire) == 0; }
+
+   private:
+      friend class JobSystem;
+
+      std::atomic<u32> value = 0;
+
+      std::mutex pendingMutex;
+      std::vector<Job> pending;
+   };
+
+   // work stealing scheduler. Each worker owns a deque, pushes and pops jobs from its back
+   // and steals from front of other workers when own deque is empty.
+   // Thread that waits on counter runs jobs too, so main thread is used as one of the workers
+   class CORE_API JobSystem {
+      NON_COPYABLE(JobSystem);
+   public:
+      // nWorkers = 0 - one worker per core except main thread
+      static void Init(u32 nWorkers = 0);
+      static void Term();
+      static JobSystem& Get();
+
+      void Run(const char* name, JobFunc func, JobCounter* counter = nullptr);
+      // dependency: job is scheduled only after all jobs of 'after' are done
+      void RunAfter(JobCounter& after, const char* name, JobFunc func, JobCounter* counter = nullptr);
+
+      // runs queued jobs while waiting
+      void Wait(const JobCounter& counter);
+
+      // calls func(begin, end) for ranges of [0, count) with at most batchSize elements and waits for them
+      void ParallelFor(const char* name, u32 count, u32 batchSize, const std::function<void(u32 begin, u32 end)>& func);
+
+      // including thread that waits
+      u32 NumThreads() const { return (u32)queues.size(); }
+
+      // index of current thread in [0, NumThreads()), 0 for main thread and threads not owned by job system
+      static u32 ThreadIdx();
+
+   private:
+      struct WorkerQueue {
+         std::mutex mutex;
+         std::deque<Job> jobs;
+      };
+
+      std::vector<Own<WorkerQueue>> queues;
+      std::vector<std::thread> workers;
+
+      std::atomic<u32> nQueued = 0;
+      std::atomic<bool> stop = false;
+
+      std::mutex sleepMutex;
+      std::condition_variable sleepCV;
+
+      JobSystem(u32 nWorkers);
+      ~JobSystem();
+
+      void Push(Job&& job);
+      bool TryPop(u32 threadIdx, Job& job);
+      bool TryRunOne();
+      void Execute(Job& job);
+      void WorkerLoop(u32 threadIdx);
+   };
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+// replaces global operator new/delete of module which includes it, must be included by one file per module:
+// core by MemoryTracker.cpp, apps using core dll by EntryPoint.h
+#ifdef PBE_MEMORY_TRACKING
+
+#include <new>
+
+#include "MemoryTracker.h"
+
+void* operator new(std::size_t size) {
+   void* ptr = pbe::MemoryTracker::Alloc(size);
+   if (!ptr) {
+      throw std::bad_alloc{};
+   }
+   return ptr;
+}
+
+void* operator new[](std::size_t size) {
+   return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+   return pbe::MemoryTracker::Alloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+   return pbe::MemoryTracker::Alloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+   void* ptr = pbe::MemoryTracker::Alloc(size, (std::size_t)align);
+   if (!ptr) {
+      throw std::bad_alloc{};
+   }
+   return ptr;
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+   return operator new(size, align);
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+   return pbe::MemoryTracker::Alloc(size, (std::size_t)align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+   return pbe::MemoryTracker::Alloc(size, (std::size_t)align);
+}
+
+void operator delete(void* ptr) noexcept {
+   pbe::MemoryTracker::Free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+   pbe::MemoryTracker::Free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+   pbe::MemoryTracker::Free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+   pbe::MemoryTracker::Free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+   pbe::MemoryTracker::Free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+   pbe::MemoryTracker::Free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t align) noexcept {
+   pbe::MemoryTracker::Free(ptr, (std::size_t)align);
+}
+
+void operator delete[](void* ptr, std::align_val_t align) noexcept {
+   pbe::MemoryTracker::Free(ptr, (std::size_t)align);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t align) noexcept {
+   pbe::MemoryTracker::Free(ptr, (std::size_t)align);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t align) noexcept {
+   pbe::MemoryTracker::Free(ptr, (std::size_t)align);
+}
+
+void operator delete(void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept {
+   pbe::MemoryTracker::Free(ptr, (std::size_t)align);
+}
+
+void operator delete[](void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept {
+   pbe::MemoryTracker::Free(ptr, (std::size_t)align);
+}
+
+#endif
@@ -0,0 +1,157 @@
+#include "pch.h"
+#include "MemoryTracker.h"
+#include "MemoryHook.h"
+
+#include <malloc.h>
+
+#include "CVar.h"
+#include "Log.h"
+
+
+namespace pbe {
+
+   CVarValue<u32> cvLiveBudgetMB{ "memory/live budget MB", 0 }; // 0 - no budget
+
+   static const char* sTagNames[] = {
+      "Untagged",
+      "Scene",
+      "Script",
+      "Physics",
+      "Serialize",
+      "Typer",
+      "Render",
+      "DbgRend",
+      "Shader",
+   };
+   static_assert(std::size(sTagNames) == (u32)MemoryTag::Count);
+
+   const char* MemoryTagName(MemoryTag tag) {
+      return sTagNames[(u32)tag];
+   }
+
+   // constant initialized, allocations may happen before and after main
+   struct TagCounters {
+      std::atomic<u64> nAllocs = 0;
+      std::atomic<u64> bytes = 0;
+   };
+
+   static TagCounters sTagCounters[(u32)MemoryTag::Count];
+   static std::atomic<u64> sFreedBytes = 0;
+   static std::atomic<u64> sNFrees = 0;
+
+   static thread_local MemoryTag tTag = MemoryTag::Untagged;
+
+   static MemoryTracker::Stats sStats;
+
+   // size reserved by allocator, same for alloc and free
+   static size_t AllocationSize(void* ptr, size_t align) {
+#ifdef _WIN32
+      return align ? _aligned_msize(ptr, align, 0) : _msize(ptr);
+#else
+      return malloc_usable_size(ptr);
+#endif
+   }
+
+   void* MemoryTracker::Alloc(size_t size, size_t align) {
+      size = std::max<size_t>(size, 1);
+
+#ifdef _WIN32
+      void* ptr = align ? _aligned_malloc(size, align) : malloc(size);
+#else
+      void* ptr = align ? aligned_alloc(align, (size + align - 1) / align * align) : malloc(size);
+#endif
+      if (!ptr) {
+         return nullptr;
+      }
+
+      auto& counters = sTagCounters[(u32)tTag];
+      counters.nAllocs.fetch_add(1, std::memory_order_relaxed);
+      counters.bytes.fetch_add(AllocationSize(ptr, align), std::memory_order_relaxed);
+      return ptr;
+   }
+
+   void MemoryTracker::Free(void* ptr, size_t align) {
+      if (!ptr) {
+         return;
+      }
+
+      sNFrees.fetch_add(1, std::memory_order_relaxed);
+      sFreedBytes.fetch_add(AllocationSize(ptr, align), std::memory_order_relaxed);
+
+#ifdef _WIN32
+      if (align) {
+         _aligned_free(ptr);
+         return;
+      }
+#endif
+      free(ptr);
+   }
+
+   MemoryTag MemoryTracker::GetTag() {
+      return tTag;
+   }
+
+   void MemoryTracker::SetTag(MemoryTag tag) {
+      tTag = tag;
+   }
+
+   void MemoryTracker::SetFrameBudget(MemoryTag tag, u64 nAllocs) {
+      sStats.tags[(u32)tag].frameAllocsBudget = nAllocs;
+   }
+
+   void MemoryTracker::NextFrame() {
+      if (!IsEnabled()) {
+         return;
+      }
+
+      // frees before allocs, block is counted as allocated before it can be freed
+      u64 freedBytes = sFreedBytes.load(std::memory_order_relaxed);
+      u64 nFrees = sNFrees.load(std::memory_order_relaxed);
+
+      u64 allocatedBytes = 0;
+      u64 nAllocs = 0;
+      sStats.frameAllocs = 0;
+      sStats.frameBytes = 0;
+
+      for (u32 i = 0; i < (u32)MemoryTag::Count; ++i) {
+         auto& tag = sStats.tags[i];
+         bool wasOverBudget = tag.frameAllocs > tag.frameAllocsBudget;
+
+         u64 tagAllocs = sTagCounters[i].nAllocs.load(std::memory_order_relaxed);
+         u64 tagBytes = sTagCounters[i].bytes.load(std::memory_order_relaxed);
+
+         tag.frameAllocs = tagAllocs - tag.nAllocs;
+         tag.frameBytes = tagBytes - tag.allocatedBytes;
+         tag.nAllocs = tagAllocs;
+         tag.allocatedBytes = tagBytes;
+
+         sStats.frameAllocs += tag.frameAllocs;
+         sStats.frameBytes += tag.frameBytes;
+         nAllocs += tagAllocs;
+         allocatedBytes += tagBytes;
+
+         if (tag.frameAllocs > tag.frameAllocsBudget) {
+            if (!wasOverBudget) {
+               WARN("Memory tag '{}' is over budget: {} allocations per frame, budget {}",
+                  sTagNames[i], tag.frameAllocs, tag.frameAllocsBudget);
+            }
+            ++tag.nOverBudgetFrames;
+         }
+      }
+
+      u64 prevLiveBytes = sStats.liveBytes;
+      sStats.liveBytes = allocatedBytes - freedBytes;
+      sStats.liveAllocs = nAllocs - nFrees;
+      sStats.peakLiveBytes = std::max(sStats.peakLiveBytes, sStats.liveBytes);
+
+      u64 liveBudget = (u64)cvLiveBudgetMB * 1024 * 1024;
+      if (liveBudget > 0 && sStats.liveBytes > liveBudget && prevLiveBytes <= liveBudget) {
+         WARN("Live heap memory is over budget: {:.1f} MB, budget {} MB", sStats.liveBytes / (1024. * 1024.), (u32)cvLiveBudgetMB);
+      }
+   }
+
+   const MemoryTracker::Stats& MemoryTracker::GetStats() {
+      return sStats;
+   }
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+
+#include "Core.h"
+
+
+namespace pbe {
+
+   // subsystem of allocation, set by MEMORY_TAG scope on current thread
+   enum class MemoryTag : u8 {
+      Untagged,
+      Scene,
+      Script,
+      Physics,
+      Serialize,
+      Typer,
+      Render,
+      DbgRend,
+      Shader,
+      Count,
+   };
+
+   CORE_API const char* MemoryTagName(MemoryTag tag);
+
+   // counts heap allocations of global operator new/delete (opt-in, premake --memtrack defines PBE_MEMORY_TRACKING).
+   // Live bytes are tracked globally, allocations per frame per tag. Freed memory size is taken from allocator,
+   // so allocations of modules without hook may be freed in hooked one and vice versa
+   class CORE_API MemoryTracker {
+   public:
+      struct TagStats {
+         u64 nAllocs = 0; // since start
+         u64 allocatedBytes = 0;
+
+         u64 frameAllocs = 0; // previous frame
+         u64 frameBytes = 0;
+
+         u64 frameAllocsBudget = UINT64_MAX;
+         u64 nOverBudgetFrames = 0;
+      };
+
+      struct Stats {
+         u64 liveBytes = 0;
+         u64 liveAllocs = 0;
+         u64 peakLiveBytes = 0; // sampled once per frame
+
+         u64 frameAllocs = 0;
+         u64 frameBytes = 0;
+
+         TagStats tags[(u32)MemoryTag::Count];
+      };
+
+      static constexpr bool IsEnabled() {
+#ifdef PBE_MEMORY_TRACKING
+         return true;
+#else
+         return false;
+#endif
+      }
+
+      // used by hooks in MemoryHook.h, align 0 - default alignment
+      static void* Alloc(size_t size, size_t align = 0);
+      static void Free(void* ptr, size_t align = 0);
+
+      static MemoryTag GetTag();
+      static void SetTag(MemoryTag tag);
+
+      // allocations per frame above budget are reported once per exceeding
+      static void SetFrameBudget(MemoryTag tag, u64 nAllocs);
+
+      // main thread, called by Profiler::NextFrame
+      static void NextFrame();
+
+      // as of last NextFrame
+      static const Stats& GetStats();
+   };
+
+   struct MemoryTagScope {
+      MemoryTagScope(MemoryTag tag) : prevTag(MemoryTracker::GetTag()) {
+         MemoryTracker::SetTag(tag);
+      }
+
+      ~MemoryTagScope() {
+         MemoryTracker::SetTag(prevTag);
+      }
+
+      MemoryTag prevTag;
+   };
+
+#ifdef PBE_MEMORY_TRACKING
+   #define MEMORY_TAG(Tag) MemoryTagScope CONCAT(memoryTag, __LINE__){ MemoryTag::Tag }
+#else
+   #define MEMORY_TAG(Tag)
+#endif
+
+}
@@ -1,15 +1,170 @@
 #include "pch.h"
 #include "Profiler.h"
 
+#include <bit>
+#include <mutex>
+
+#include "CVar.h"
+#include "Log.h"
+#include "MemoryTracker.h"
+#include "Ref.h"
+
 namespace pbe {
 
+   CVarValue<float> cvHitchBudgetMs{ "profiler/hitch/budget ms", 33.3f };
+   CVarValue<bool> cvHitchLog{ "profiler/hitch/log", false };
+
    static Profiler* sProfiler = nullptr;
 
+   u32 TimeHistogram::BucketIdx(u64 us) {
+      if (us < SubBuckets) {
+         return (u32)us;
+      }
+
+      u32 msb = 63 - (u32)std::countl_zero(us);
+      if (msb >= MaxBits) {
+         return NBuckets - 1;
+      }
+
+      // SubBuckets linear buckets per power of two
+      u32 shift = msb - SubBucketBits;
+      return (shift + 1) * SubBuckets + u32(us >> shift) - SubBuckets;
+   }
+
+   float TimeHistogram::BucketBeginMs(u32 idx) {
+      if (idx < SubBuckets) {
+         return float(idx) / 1000.f;
+      }
+      u32 shift = idx / SubBuckets - 1;
+      u64 sub = idx % SubBuckets + SubBuckets;
+      return float(sub << shift) / 1000.f;
+   }
+
+   float TimeHistogram::BucketEndMs(u32 idx) {
+      if (idx < SubBuckets) {
+         return float(idx + 1) / 1000.f;
+      }
+      u32 shift = idx / SubBuckets - 1;
+      u64 sub = idx % SubBuckets + SubBuckets;
+      return float((sub + 1) << shift) / 1000.f;
+   }
+
+   void TimeHistogram::Add(float ms) {
+      u64 us = ms > 0 ? u64(ms * 1000.f) : 0;
+      ++buckets[BucketIdx(us)];
+      ++count;
+   }
+
+   void TimeHistogram::Clear() {
+      std::ranges::fill(buckets, 0);
+      count = 0;
+   }
+
+   float TimeHistogram::Percentile(float p) const {
+      if (count == 0) {
+         return 0;
+      }
+
+      u64 rank = std::clamp<u64>((u64)std::ceil(p / 100.f * (float)count), 1, count);
+      u64 nBelow = 0;
+      for (u32 i = 0; i < NBuckets; ++i) {
+         nBelow += buckets[i];
+         if (nBelow >= rank) {
+            return BucketEndMs(i);
+         }
+      }
+      return BucketEndMs(NBuckets - 1);
+   }
+
+   void TimeStats::Add(float ms) {
+      if (nSamples == HistoryLength) {
+         sum -= samples[head];
+      } else {
+         ++nSamples;
+      }
+
+      samples[head] = ms;
+      head = (head + 1) % HistoryLength;
+      sum += ms;
+
+      histogram.Add(ms);
+   }
+
+   void TimeStats::Clear() {
+      head = 0;
+      nSamples = 0;
+      sum = 0;
+      histogram.Clear();
+   }
+
+   TimeSummary TimeStats::Summarize() const {
+      TimeSummary summary;
+      if (nSamples == 0) {
+         return summary;
+      }
+
+      // ring order does not matter for percentiles
+      float sorted[HistoryLength];
+      std::copy_n(samples, nSamples, sorted);
+      std::sort(sorted, sorted + nSamples);
+
+      // nearest rank
+      auto percentile = [&](float p) {
+         u32 rank = (u32)std::ceil(p / 100.f * (float)nSamples);
+         return sorted[std::clamp(rank, 1u, nSamples) - 1];
+      };
+
+      summary.cur = GetCur();
+      summary.mean = GetAverage();
+      summary.min = sorted[0];
+      summary.max = sorted[nSamples - 1];
+      summary.p50 = percentile(50);
+      summary.p95 = percentile(95);
+      summary.p99 = percentile(99);
+      return summary;
+   }
+
+   // totals since thread start, written only by owning thread, read by NextFrame
+   struct ThreadCpuEvents {
+      struct Slot {
+         std::atomic<u64> ticks = 0;
+         std::atomic<u64> count = 0;
+      };
+      Slot slots[Profiler::MaxCpuEvents];
+   };
+
+   // independent of Profiler instance, static descriptors may register before Init
+   struct CpuEventRegistry {
+      std::mutex mutex;
+      std::vector<std::string_view> names;
+      std::unordered_map<std::string_view, u32> indices;
+      // never removed, totals of finished threads stay in sums
+      std::vector<Own<ThreadCpuEvents>> threads;
+   };
+
+   static CpuEventRegistry& GetRegistry() {
+      static CpuEventRegistry registry;
+      return registry;
+   }
+
+   static thread_local ThreadCpuEvents* tCpuEvents = nullptr;
+
+   static ThreadCpuEvents& GetThreadCpuEvents() {
+      if (!tCpuEvents) {
+         auto& registry = GetRegistry();
+         std::lock_guard lock{ registry.mutex };
+         tCpuEvents = registry.threads.emplace_back(std::make_unique<ThreadCpuEvents>()).get();
+      }
+      return *tCpuEvents;
+   }
+
    void Profiler::Init() {
       sProfiler = new Profiler();
+      CpuTrace::Init();
    }
 
    void Profiler::Term() {
+      CpuTrace::Term();
       delete sProfiler;
    }
 
@@ -17,9 +172,160 @@ namespace pbe {
       return *sProfiler;
    }
 
+   u32 Profiler::RegisterCpuEvent(std::string_view name) {
+      auto& registry = GetRegistry();
+      std::lock_guard lock{ registry.mutex };
+
+      auto it = registry.indices.find(name);
+      if (it != registry.indices.end()) {
+         return it->second;
+      }
+
+      if (registry.names.size() == MaxCpuEvents) {
+         ASSERT_MESSAGE(false, "Too many profiler cpu events");
+         return MaxCpuEvents - 1;
+      }
+
+      u32 idx = (u32)registry.names.size();
+      registry.names.push_back(name);
+      registry.indices[name] = idx;
+      return idx;
+   }
+
+   void Profiler::AddCpuTime(u32 eventIdx, u64 ticks) {
+      // single writer, no need in atomic rmw
+      auto& slot = GetThreadCpuEvents().slots[eventIdx];
+      slot.ticks.store(slot.ticks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+      slot.count.store(slot.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   }
+
+   void Profiler::NextFrame() {
+      CpuTrace::NextFrame();
+      MemoryTracker::NextFrame();
+
+      double msPerTick = CpuTrace::MsPerTick();
+
+      u64 nowTicks = CpuTrace::Now();
+      bool frameEnded = frameBeginTicks != 0;
+      float frameMs = frameEnded ? float(double(nowTicks - frameBeginTicks) * msPerTick) : 0;
+      frameBeginTicks = nowTicks;
+
+      std::vector<u64> ticks;
+      std::vector<u64> counts;
+      {
+         auto& registry = GetRegistry();
+         std::lock_guard lock{ registry.mutex };
+
+         u32 nEvents = (u32)registry.names.size();
+         for (u32 i = (u32)cpuEvents.size(); i < nEvents; ++i) {
+            cpuEvents.push_back(CpuEvent{
+               .name = registry.names[i],
+               .elapsedMsCur = 0,
+               .countCur = 0,
+               .stats = {},
+               .usedInFrame = false,
+            });
+         }
+
+         ticks.resize(nEvents);
+         counts.resize(nEvents);
+         for (const auto& thread : registry.threads) {
+            for (u32 i = 0; i < nEvents; ++i) {
+               ticks[i] += thread->slots[i].ticks.load(std::memory_order_relaxed);
+               counts[i] += thread->slots[i].count.load(std::memory_order_relaxed);
+            }
+         }
+      }
+
+      prevTicks.resize(ticks.size());
+      prevCounts.resize(counts.size());
+
+      for (u32 i = 0; i < (u32)cpuEvents.size(); ++i) {
+         auto& event = cpuEvents[i];
+
+         u64 count = counts[i] - prevCounts[i];
+         event.usedInFrame = count > 0;
+         event.countCur = (u32)count;
+
+         // stats keep only frames where event was used
+         event.elapsedMsCur = event.usedInFrame ? float(double(ticks[i] - prevTicks[i]) * msPerTick) : 0;
+         if (event.usedInFrame) {
+            event.stats.Add(event.elapsedMsCur);
+         }
+      }
+
+      prevTicks = std::move(ticks);
+      prevCounts = std::move(counts);
+
+      if (frameEnded) {
+         frameTime.Add(frameMs);
+         DetectHitch(frameMs);
+         ++frameIdx;
+      }
+
+#ifndef PBE_HEADLESS
+      for (auto& [name, event] : gpuEvents) {
+         if (event.usedInFrame) {
+            event.usedInFrame = false;
+
+            event.timerIdx = (event.timerIdx + 1) % 3;
+
+            ASSERT(event.timers[event.timerIdx]->IsReady());
+
+            if (event.timers[event.timerIdx]->IsReady()) {
+               event.stats.Add(event.timers[event.timerIdx]->GetTimeMs());
+            }
+         }
+      }
+#endif
+   }
+
+   void Profiler::DetectHitch(float frameMs) {
+      if (frameMs <= cvHitchBudgetMs) {
+         return;
+      }
+
+      Hitch hitch{ .frameIdx = frameIdx, .frameMs = frameMs, .scopes = {} };
+      for (const auto& event : cpuEvents) {
+         if (event.usedInFrame) {
+            hitch.scopes.emplace_back(event.name, event.elapsedMsCur);
+         }
+      }
+
+      std::ranges::sort(hitch.scopes, std::greater{}, [](const auto& scope) { return scope.second; });
+      if (hitch.scopes.size() > MaxHitchScopes) {
+         hitch.scopes.resize(MaxHitchScopes);
+      }
+
+      if (cvHitchLog) {
+         string scopes;
+         for (const auto& [name, ms] : hitch.scopes) {
+            scopes += std::format("{}{} {:.2f} ms", scopes.empty() ? "" : ", ", name, ms);
+         }
+         WARN("Hitch at frame {}: {:.2f} ms ({})", hitch.frameIdx, hitch.frameMs, scopes);
+      }
+
+      hitches.emplace_back(std::move(hitch));
+      if (hitches.size() > MaxHitches) {
+         hitches.pop_front();
+      }
+      ++nHitches;
+   }
+
+   const Profiler::CpuEvent* Profiler::FindCpuEvent(std::string_view name) const {
+      for (const auto& event : cpuEvents) {
+         if (event.name == name) {
+            return &event;
+         }
+      }
+      return nullptr;
+   }
+
+#ifndef PBE_HEADLESS
    Profiler::GpuEvent::GpuEvent() {
       for (auto& timer : timers) {
          timer = Ref<GpuTimer>::Create();
       }
    }
+#endif
 }
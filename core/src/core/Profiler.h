@@ -5,15 +5,19 @@
 
 #include "Assert.h"
 #include "Common.h"
+#include "CpuTrace.h"
+#include "Thread.h"
 #include "optick.h"
-#include "rend/GpuTimer.h"
 
 // todo:
 // #if !defined(RELEASE)
    #define USE_PROFILE
+#ifndef PBE_HEADLESS
    #define USE_PIX_RETAIL
-#include "rend/CommandList.h"
+   #include "rend/GpuTimer.h"
+   #include "rend/CommandList.h"
    #include "WinPixEventRuntime/pix3.h"
+#endif
 // #endif
 
 
@@ -43,6 +47,67 @@ namespace pbe {
       std::chrono::time_point<std::chrono::high_resolution_clock> tStart = std::chrono::high_resolution_clock::now();
    };
 
+   // log-linear buckets of microseconds (hdr histogram), ~6% precision with constant memory for any number of samples
+   struct CORE_API TimeHistogram {
+      static constexpr u32 SubBucketBits = 4;
+      static constexpr u32 SubBuckets = 1 << SubBucketBits;
+      static constexpr u32 MaxBits = 27; // ~134 s
+      static constexpr u32 NBuckets = (MaxBits - SubBucketBits + 1) * SubBuckets;
+
+      void Add(float ms);
+      void Clear();
+
+      // upper bound of bucket which contains percentile p in [0, 100]
+      float Percentile(float p) const;
+
+      u64 Count() const { return count; }
+      u32 BucketCount(u32 idx) const { return buckets[idx]; }
+      // [begin, end) of bucket in ms
+      static float BucketBeginMs(u32 idx);
+      static float BucketEndMs(u32 idx);
+
+      static u32 BucketIdx(u64 us);
+
+   private:
+      u32 buckets[NBuckets] = {};
+      u64 count = 0;
+   };
+
+   struct TimeSummary {
+      float cur = 0;
+      float mean = 0;
+      float min = 0;
+      float max = 0;
+      float p50 = 0;
+      float p95 = 0;
+      float p99 = 0;
+   };
+
+   // last HistoryLength samples in fixed ring and histogram of all samples since Clear
+   struct CORE_API TimeStats {
+      static constexpr u32 HistoryLength = 256;
+
+      void Add(float ms);
+      void Clear();
+
+      float GetCur() const { return nSamples > 0 ? samples[(head + HistoryLength - 1) % HistoryLength] : 0; }
+      float GetAverage() const { return nSamples > 0 ? float(sum / nSamples) : 0; }
+
+      // percentiles over history, sorts copy of history
+      TimeSummary Summarize() const;
+
+      u32 NumSamples() const { return nSamples; }
+      const TimeHistogram& Histogram() const { return histogram; }
+
+   private:
+      float samples[HistoryLength] = {};
+      u32 head = 0;
+      u32 nSamples = 0;
+      double sum = 0;
+
+      TimeHistogram histogram;
+   };
+
    class CORE_API Profiler {
       NON_COPYABLE(Profiler);
    public:
@@ -52,60 +117,24 @@ namespace pbe {
       static void Term();
       static Profiler& Get();
 
-      struct AverageTime {
-         void Add(float time, int maxValues) {
-            average += time;
-            times.push_back(time);
-            while (times.size() > maxValues) {
-               average -= times.front();
-               times.pop_front();
-            }
-         }
-
-         float GetCur() const {
-            return times.empty() ? 0 : times.back();
-         }
-
-         float GetAverage() const {
-            return times.empty() ? 0 : average / times.size();
-         }
-
-         void Clear() {
-            times.clear();
-            average = 0;
-         }
-
-      private:
-         std::deque<float> times;
-         float average = 0;
-      };
-
+      // merged from all threads in NextFrame, time is summed over scope entries of previous frame
       struct CpuEvent {
-         std::string name;
-         CpuTimer timer;
+         std::string_view name;
          float elapsedMsCur = 0;
+         u32 countCur = 0;
 
-         AverageTime averageTime;
+         TimeStats stats;
 
          bool usedInFrame = false;
-
-         void Start() {
-            ASSERT(usedInFrame == false);
-            usedInFrame = true;
-            timer.Start();
-         }
-
-         void Stop() {
-            elapsedMsCur = timer.ElapsedMs();
-         }
       };
 
+#ifndef PBE_HEADLESS
       struct GpuEvent {
          std::string name;
          Ref<GpuTimer> timers[3];
          int timerIdx = 0;
 
-         AverageTime averageTime;
+         TimeStats stats;
 
          bool usedInFrame = false;
 
@@ -121,47 +150,31 @@ namespace pbe {
             cmd.EndTimeQuery(timers[timerIdx]);
          }
       };
+#endif
 
-      int historyLength = 30;
-
-      void NextFrame() {
-         for (auto& [name, event] : cpuEvents) {
-            if (event.usedInFrame) {
-               event.usedInFrame = false;
-
-               event.averageTime.Add(event.elapsedMsCur, historyLength);
-               event.elapsedMsCur = -1;
-            } else {
-               event.averageTime.Clear();
-            }
-         }
-
-         for (auto& [name, event] : gpuEvents) {
-            if (event.usedInFrame) {
-               event.usedInFrame = false;
+      // frame over budget, scopes are most expensive cpu events of that frame (nested scopes included in parents)
+      struct Hitch {
+         u64 frameIdx = 0;
+         float frameMs = 0;
+         std::vector<std::pair<std::string_view, float>> scopes;
+      };
 
-               event.timerIdx = (event.timerIdx + 1) % 3;
+      static constexpr u32 MaxHitches = 32;
+      static constexpr u32 MaxHitchScopes = 8;
 
-               ASSERT(event.timers[event.timerIdx]->IsReady());
+      // max registered PROFILE_CPU names
+      static constexpr u32 MaxCpuEvents = 1024;
 
-               if (event.timers[event.timerIdx]->IsReady()) {
-                  event.averageTime.Add(event.timers[event.timerIdx]->GetTimeMs(), historyLength);
-               }
-            } else {
-               event.averageTime.Clear();
-            }
-         }
-      }
+      // once per call site, same names share index
+      static u32 RegisterCpuEvent(std::string_view name);
+      // any thread, accumulated in thread local slots
+      static void AddCpuTime(u32 eventIdx, u64 ticks);
 
-      CpuEvent& CreateCpuEvent(std::string_view name) {
-         if (cpuEvents.find(name) == cpuEvents.end()) {
-            cpuEvents[name] = CpuEvent{name.data()};
-         }
+      void NextFrame();
 
-         CpuEvent& cpuEvent = cpuEvents[name];
-         return cpuEvent;
-      }
+      const CpuEvent* FindCpuEvent(std::string_view name) const;
 
+#ifndef PBE_HEADLESS
       GpuEvent& CreateGpuEvent(std::string_view name) {
          if (gpuEvents.find(name) == gpuEvents.end()) {
             gpuEvents[name] = GpuEvent{};
@@ -172,23 +185,61 @@ namespace pbe {
          return gpuEvent;
       }
 
-      std::unordered_map<std::string_view, CpuEvent> cpuEvents;
+#endif
+
+      // cpu time between NextFrame calls
+      TimeStats frameTime;
+      u64 frameIdx = 0;
+
+      // last MaxHitches
+      std::deque<Hitch> hitches;
+      u64 nHitches = 0;
+
+      // indexed by CpuEventDesc::idx
+      std::vector<CpuEvent> cpuEvents;
+#ifndef PBE_HEADLESS
       std::unordered_map<std::string_view, GpuEvent> gpuEvents;
+#endif
+
+   private:
+      // totals of all threads at last NextFrame
+      std::vector<u64> prevTicks;
+      std::vector<u64> prevCounts;
+
+      u64 frameBeginTicks = 0;
+
+      void DetectHitch(float frameMs);
+   };
+
+   // static per PROFILE_CPU call site, registered on first entry
+   struct CpuEventDesc {
+      CpuEventDesc(std::string_view name) : name(name), idx(Profiler::RegisterCpuEvent(name)) {}
+
+      std::string_view name;
+      u32 idx;
    };
 
    struct CpuEventGuard {
-      CpuEventGuard(Profiler::CpuEvent& cpu_event)
-         : cpuEvent(cpu_event) {
-         cpuEvent.Start();
+      CpuEventGuard(const CpuEventDesc& desc) : desc(desc) {
+         traced = CpuTrace::IsEnabled();
+         begin = traced ? CpuTrace::BeginScope() : CpuTrace::Now();
       }
 
       ~CpuEventGuard() {
-         cpuEvent.Stop();
+         u64 end = CpuTrace::Now();
+         Profiler::AddCpuTime(desc.idx, end - begin);
+
+         if (traced) {
+            CpuTrace::EndScope(desc.name, begin, end);
+         }
       }
 
-      Profiler::CpuEvent& cpuEvent;
+      const CpuEventDesc& desc;
+      u64 begin = 0;
+      bool traced = false;
    };
 
+#ifndef PBE_HEADLESS
    struct GpuEventGuard {
       GpuEventGuard(CommandList& cmd, Profiler::GpuEvent& gpuEvent)
          : cmd(cmd), gpuEvent(gpuEvent) {
@@ -202,6 +253,7 @@ namespace pbe {
       CommandList& cmd;
       Profiler::GpuEvent& gpuEvent;
    };
+#endif
 
    enum class ProfileEventType : u8 {
       Frame,
@@ -211,25 +263,33 @@ namespace pbe {
       Window,
    };
 
-#ifdef USE_PROFILE
+#ifdef USE_PIX_RETAIL
    // PIXSetMarker(PIX_COLOR_INDEX(17), "Some data");
 
    #define PIX_EVENT_COLOR(Color, Name) PIXScopedEvent(Color, Name)
    #define PIX_EVENT(Name) PIX_EVENT_COLOR(PIX_COLOR(255, 255, 255), Name)
    #define PIX_EVENT_SYSTEM(System, Name) PIX_EVENT_COLOR(PIX_COLOR_INDEX((BYTE)ProfileEventType::System), Name)
+#else
+   #define PIX_EVENT_COLOR(Color, Name)
+   #define PIX_EVENT(Name)
+   #define PIX_EVENT_SYSTEM(System, Name)
+#endif
+
+#ifdef USE_PROFILE
 
    // todo: move to mb Core.h?
    #define __SCOPED_NAME(Name, line) CONCAT(Name, line)
    #define SCOPED_NAME(Name) __SCOPED_NAME(Name, __LINE__)
 
-   #define PROFILE_CPU(Name) CpuEventGuard SCOPED_NAME(cpuEvent){ Profiler::Get().CreateCpuEvent(Name) }; PIX_EVENT(Name)
-   #define __PROFILE_GPU(Cmd, Name) GpuEventGuard SCOPED_NAME(gpuEvent){ Cmd, Profiler::Get().CreateGpuEvent(Name) }
-   #define PROFILE_GPU(Name) __PROFILE_GPU(cmd, Name)
+   #define PROFILE_CPU(Name) static const CpuEventDesc SCOPED_NAME(cpuEventDesc){ Name }; \
+      CpuEventGuard SCOPED_NAME(cpuEvent){ SCOPED_NAME(cpuEventDesc) }; PIX_EVENT(Name); OPTICK_EVENT(Name)
+   #ifndef PBE_HEADLESS
+      #define __PROFILE_GPU(Cmd, Name) GpuEventGuard SCOPED_NAME(gpuEvent){ Cmd, Profiler::Get().CreateGpuEvent(Name) }
+      #define PROFILE_GPU(Name) __PROFILE_GPU(cmd, Name)
+   #else
+      #define PROFILE_GPU(Name)
+   #endif
 #else
-   #define PIX_EVENT_COLOR(Color, Name)
-   #define PIX_EVENT(Name)
-   #define PIX_EVENT_SYSTEM(System, Name)
-
    #define PROFILE_CPU(Name)
    #define PROFILE_GPU(Name)
 #endif
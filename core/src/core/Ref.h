@@ -1,6 +1,7 @@
 #pragma once
 
 #include <assert.h>
+#include <atomic>
 #include <memory>
 #include <stdint.h>
 
@@ -8,23 +9,49 @@
 
 namespace pbe {
 
+   // PBE_REF_COUNT_SINGLE_THREADED - plain counter, Ref must not be shared between threads
+#ifdef PBE_REF_COUNT_SINGLE_THREADED
+   struct RefCount {
+      void Inc() { ++value; }
+      u32 Dec() { return --value; }
+      u32 Get() const { return value; }
+
+      u32 value = 0;
+   };
+#else
+   // increment may be relaxed, new reference is made from existing one. Decrement is acq_rel,
+   // so writes of all owners are visible to the one who deletes
+   struct RefCount {
+      void Inc() { value.fetch_add(1, std::memory_order_relaxed); }
+      u32 Dec() { return value.fetch_sub(1, std::memory_order_acq_rel) - 1; }
+      u32 Get() const { return value.load(std::memory_order_relaxed); }
+
+      std::atomic<u32> value = 0;
+   };
+#endif
+
    class CORE_API RefCounted {
    public:
+      RefCounted() = default;
+      // copy is a new object without references
+      RefCounted(const RefCounted&) {}
+
       void IncRefCount() const {
-         refCount++;
+         refCount.Inc();
       }
 
-      void DecRefCount() const {
-         assert(refCount > 0);
-         refCount--;
+      // returns references left
+      u32 DecRefCount() const {
+         assert(refCount.Get() > 0);
+         return refCount.Dec();
       }
 
-      uint32_t GetRefCount() const { return refCount; }
+      uint32_t GetRefCount() const { return refCount.Get(); }
 
       RefCounted& operator=(const RefCounted&) = delete;
 
    private:
-      mutable uint32_t refCount = 0;
+      mutable RefCount refCount;
    };
 
    template <typename T>
@@ -49,7 +76,7 @@ namespace pbe {
       }
 
       template <typename T2>
-      Ref(Ref<T2>&& other) {
+      Ref(Ref<T2>&& other) noexcept {
          instance = (T*)other.instance;
          other.instance = nullptr;
       }
@@ -63,6 +90,11 @@ namespace pbe {
          IncRef();
       }
 
+      Ref(Ref<T>&& other) noexcept
+         : instance(other.instance) {
+         other.instance = nullptr;
+      }
+
       Ref& operator=(std::nullptr_t) {
          DecRef();
          instance = nullptr;
@@ -77,6 +109,16 @@ namespace pbe {
          return *this;
       }
 
+      // takes reference of other, no ref count change
+      Ref& operator=(Ref<T>&& other) noexcept {
+         if (this != &other) {
+            DecRef();
+            instance = other.instance;
+            other.instance = nullptr;
+         }
+         return *this;
+      }
+
       template <typename T2>
       Ref& operator=(const Ref<T2>& other) {
          other.IncRef();
@@ -87,11 +129,12 @@ namespace pbe {
       }
 
       template <typename T2>
-      Ref& operator=(Ref<T2>&& other) {
-         DecRef();
-
-         instance = other.instance;
+      Ref& operator=(Ref<T2>&& other) noexcept {
+         T* newInstance = other.instance;
          other.instance = nullptr;
+
+         DecRef();
+         instance = newInstance;
          return *this;
       }
 
@@ -110,10 +153,43 @@ namespace pbe {
       operator T* () { return instance; }
 
       void Reset(T* instance_ = nullptr) {
+         if (instance_) {
+            instance_->IncRefCount();
+         }
          DecRef();
          instance = instance_;
       }
 
+      void Swap(Ref<T>& other) noexcept {
+         std::swap(instance, other.instance);
+      }
+
+      // gives up ownership without decrement, pair with Adopt
+      T* Detach() {
+         T* detached = instance;
+         instance = nullptr;
+         return detached;
+      }
+
+      // takes ownership of reference counted by earlier Detach or IncRefCount
+      static Ref<T> Adopt(T* instance) {
+         Ref<T> ref;
+         ref.instance = instance;
+         return ref;
+      }
+
+      // cast copy, increments ref count
+      template <typename T2>
+      Ref<T2> As() const& {
+         return Ref<T2>(*this);
+      }
+
+      // cast of temporary, ownership is moved without ref count change
+      template <typename T2>
+      Ref<T2> As() && {
+         return Ref<T2>(std::move(*this));
+      }
+
       template <typename... Args>
       static Ref<T> Create(Args&&... args) {
          return Ref<T>(new T(std::forward<Args>(args)...));
@@ -126,11 +202,9 @@ namespace pbe {
       }
 
       void DecRef() const {
-         if (instance) {
-            instance->DecRefCount();
-            if (instance->GetRefCount() == 0) {
-               delete instance;
-            }
+         // only one owner sees zero
+         if (instance && instance->DecRefCount() == 0) {
+            delete instance;
          }
       }
 
@@ -1,20 +1,61 @@
 #include "pch.h"
 #include "StringID.h"
 
+#include <shared_mutex>
+
+#include "Assert.h"
+
 
 namespace pbe {
 
-   // todo: slow hash function
-   static std::unordered_map<std::string, int> sStringIDs;
+   // sharded by hash, mostly read - same strings are interned again and again
+   struct StringIDShard {
+      std::shared_mutex mutex;
+      std::unordered_map<u64, std::string> strings;
+   };
+
+   static constexpr u32 NShards = 16;
+
+   // function static, ids may be created during static initialization
+   static StringIDShard& GetShard(u64 hash) {
+      static StringIDShard sShards[NShards];
+      return sShards[hash % NShards];
+   }
+
+   // node based map, string is never moved
+   static std::string_view Intern(u64 hash, std::string_view str) {
+      auto& shard = GetShard(hash);
+
+      {
+         std::shared_lock lock{ shard.mutex };
+         auto it = shard.strings.find(hash);
+         if (it != shard.strings.end()) {
+            ASSERT_MESSAGE(it->second == str, "StringID hash collision");
+            return it->second;
+         }
+      }
+
+      std::unique_lock lock{ shard.mutex };
+      return shard.strings.try_emplace(hash, str).first->second;
+   }
 
-   StringID::StringID(std::string_view str) {
-      auto it = sStringIDs.find(str.data());
-      if (it == sStringIDs.end()) {
-         id = (int)sStringIDs.size();
-         sStringIDs[str.data()] = id;
-      } else {
-         id = it->second;
+   StringID::StringID(std::string_view str) : hash(HashStr(str)) {
+      Intern(hash, str);
+   }
+
+   std::string_view StringID::GetStr() const {
+#if defined(DEBUG)
+      // literal ids are registered lazily, so ids copied by hash resolve after first use
+      if (literal) {
+         return Intern(hash, { literal, literalSize });
       }
+#endif
+
+      auto& shard = GetShard(hash);
+
+      std::shared_lock lock{ shard.mutex };
+      auto it = shard.strings.find(hash);
+      return it != shard.strings.end() ? std::string_view{ it->second } : std::string_view{};
    }
 
 }
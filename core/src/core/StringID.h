@@ -1,16 +1,58 @@
 #pragma once
 
+#include "Core.h"
+#include "utils/Hash.h"
+
 namespace pbe {
 
-   class StringID {
+   // 64 bit string hash. Literals are hashed at compile time, runtime strings are interned,
+   // so string of id may be looked up for debugging. In debug literal is kept in id and interned on first GetStr
+   class CORE_API StringID {
    public:
-      StringID() = default;
-      StringID(std::string_view str);
+      constexpr StringID() = default;
+
+      template<size_t N>
+      consteval StringID(const char (&str)[N]) : hash(HashStr({ str, N - 1 }))
+#if defined(DEBUG)
+         , literal(str), literalSize(N - 1)
+#endif
+      {}
+
+      explicit StringID(std::string_view str);
+
+      static constexpr StringID FromHash(u64 hash) {
+         StringID id;
+         id.hash = hash;
+         return id;
+      }
+
+      constexpr u64 GetHash() const { return hash; }
+      constexpr bool Valid() const { return hash != 0; }
+
+      // interned string. In release empty if id was built only from literal
+      std::string_view GetStr() const;
 
-      int GetID() const { return id; }
+      constexpr bool operator==(const StringID& rhs) const { return hash == rhs.hash; }
 
    private:
-      int id = -1;
+      u64 hash = 0;
+
+#if defined(DEBUG)
+      // string literal, static storage
+      const char* literal = nullptr;
+      u32 literalSize = 0;
+#endif
+   };
+
+}
+
+namespace std {
+
+   template <>
+   struct hash<pbe::StringID> {
+      std::size_t operator()(const pbe::StringID& id) const {
+         return (std::size_t)id.GetHash();
+      }
    };
 
 }
@@ -5,9 +5,15 @@
 
 namespace pbe {
 
+   static const std::thread::id sMainThreadId = std::this_thread::get_id();
+
    void ThreadSleepMs(float ms) {
       int ims = std::max(int(ms), 1);
       std::this_thread::sleep_for(std::chrono::milliseconds(ims));
    }
 
+   bool IsMainThread() {
+      return std::this_thread::get_id() == sMainThreadId;
+   }
+
 }
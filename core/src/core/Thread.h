@@ -1,7 +1,12 @@
 #pragma once
 
+#include "Core.h"
+
 namespace pbe {
 
    void ThreadSleepMs(float ms);
 
+   // thread that loaded core module
+   CORE_API bool IsMainThread();
+
 }
@@ -1,15 +1,14 @@
 #include "pch.h"
 #include "UUID.h"
 
-#include <random>
+#include "math/Random.h"
 
 namespace pbe {
 
-   static std::random_device sRandomDevice;
-   static std::mt19937_64 sEng(sRandomDevice());
-   static std::uniform_int_distribution<uint64_t> sDistribution;
+   // own generator, uuids must stay unique when Random is seeded deterministically
+   static thread_local RandomGenerator tUUIDGenerator{ RandomGenerator::NondeterministicSeed() };
 
-   UUID::UUID() : uuid(sDistribution(sEng)) {}
+   UUID::UUID() : uuid(tUUIDGenerator.U64()) {}
 
    bool UUID::Valid() const {
       return uuid != (u64)UUID_INVALID;
@@ -1,6 +1,13 @@
 #include "pch.h"
 #include "FileSystem.h"
 
+#ifndef _WIN32
+   #include <fcntl.h>
+   #include <sys/mman.h>
+   #include <sys/stat.h>
+   #include <unistd.h>
+#endif
+
 namespace pbe {
 
    std::string ReadFileAsString(std::string_view filename) {
@@ -14,6 +21,9 @@ namespace pbe {
    }
 
    std::string OpenFileDialog(const OpenFileDialogCfg& cfg) {
+#ifdef PBE_HEADLESS
+      return {};
+#else
       OPENFILENAMEA ofn{};
       CHAR szFile[260] = { 0 };
 
@@ -32,9 +42,104 @@ namespace pbe {
          return std::filesystem::relative(ofn.lpstrFile).string();
       }
       return {};
+#endif
    }
 
    void OpenFileExplorer(const string_view path) {
+#ifndef PBE_HEADLESS
       ShellExecuteA(NULL, "open", path.data(), NULL, NULL, SW_SHOWDEFAULT);
+#endif
+   }
+
+   MappedFile::MappedFile(std::string_view filename) {
+      std::string path{ filename };
+
+#ifdef _WIN32
+      HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (hFile == INVALID_HANDLE_VALUE) {
+         return;
+      }
+      file = hFile;
+
+      LARGE_INTEGER fileSize{};
+      if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0) {
+         Close();
+         return;
+      }
+
+      mapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (!mapping) {
+         Close();
+         return;
+      }
+
+      data = (const u8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      if (!data) {
+         Close();
+         return;
+      }
+      size = (size_t)fileSize.QuadPart;
+#else
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+         return;
+      }
+
+      struct stat st{};
+      if (fstat(fd, &st) == 0 && st.st_size > 0) {
+         void* ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (ptr != MAP_FAILED) {
+            data = (const u8*)ptr;
+            size = (size_t)st.st_size;
+         }
+      }
+      // mapping keeps file referenced
+      close(fd);
+#endif
    }
+
+   MappedFile::~MappedFile() {
+      Close();
+   }
+
+   MappedFile::MappedFile(MappedFile&& other) noexcept {
+      *this = std::move(other);
+   }
+
+   MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+      if (this != &other) {
+         Close();
+         std::swap(data, other.data);
+         std::swap(size, other.size);
+#ifdef _WIN32
+         std::swap(file, other.file);
+         std::swap(mapping, other.mapping);
+#endif
+      }
+      return *this;
+   }
+
+   void MappedFile::Close() {
+#ifdef _WIN32
+      if (data) {
+         UnmapViewOfFile(data);
+      }
+      if (mapping) {
+         CloseHandle(mapping);
+      }
+      if (file) {
+         CloseHandle(file);
+      }
+      file = nullptr;
+      mapping = nullptr;
+#else
+      if (data) {
+         munmap((void*)data, size);
+      }
+#endif
+      data = nullptr;
+      size = 0;
+   }
+
 }
@@ -20,4 +20,33 @@ namespace pbe {
 
    CORE_API void OpenFileExplorer(const string_view path);
 
+   // read only mapping of whole file, data is valid while object lives
+   class CORE_API MappedFile {
+   public:
+      MappedFile() = default;
+      MappedFile(std::string_view filename);
+      ~MappedFile();
+
+      MappedFile(MappedFile&& other) noexcept;
+      MappedFile& operator=(MappedFile&& other) noexcept;
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+
+      const u8* Data() const { return data; }
+      size_t Size() const { return size; }
+
+      bool Valid() const { return data != nullptr; }
+
+   private:
+      const u8* data = nullptr;
+      size_t size = 0;
+
+#ifdef _WIN32
+      void* file = nullptr;
+      void* mapping = nullptr;
+#endif
+
+      void Close();
+   };
+
 }
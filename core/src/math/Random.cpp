@@ -2,44 +2,128 @@
 #include "Random.h"
 #include "Types.h"
 
+#include <mutex>
+
 namespace pbe {
 
-   // todo: use faster random generator
-   // todo: not thread safe
-   static std::random_device sRandomDevice;
-   static std::mt19937_64 sEng(sRandomDevice());
+   static u64 SplitMix64(u64& state) {
+      u64 z = (state += 0x9e3779b97f4a7c15ull);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      return z ^ (z >> 31);
+   }
 
-   u32 pcg_hash(u32 input) {
-      u32 state = input * 747796405u + 2891336453u;
-      u32 word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
-      return (word >> 22u) ^ word;
+   RandomGenerator::RandomGenerator(u64 seed, u64 stream) {
+      // half of state from seed and half from stream. Splitmix output is bijective in its counter,
+      // so different (seed, stream) pairs always give different states, and state is never all zero
+      u64 seedState = seed;
+      u64 streamState = stream;
+      s[0] = SplitMix64(seedState);
+      s[1] = SplitMix64(seedState);
+      s[2] = SplitMix64(streamState);
+      s[3] = SplitMix64(streamState);
    }
 
-   float Random::FloatSeeded(u32 seed) {
-      seed = pcg_hash(seed);
-      return (float)seed / (float)u32(-1);
+   u64 RandomGenerator::NondeterministicSeed() {
+      static std::random_device sRandomDevice;
+      static std::mutex sMutex;
+
+      std::lock_guard lock{ sMutex };
+      return (u64(sRandomDevice()) << 32) | sRandomDevice();
    }
 
-   bool Random::Bool(float trueChance) {
-      return Float(0.f, 1.f) < trueChance;
+   vec3 RandomGenerator::UniformInSphere() {
+      vec3 dir = UniformOnSphere();
+      return dir * std::cbrt(Float());
    }
 
-   float Random::Float(float min, float max) {
-      std::uniform_real_distribution distribution{ min, max };
-      return distribution(sEng);
+   vec3 RandomGenerator::UniformOnSphere() {
+      float z = Float(-1.f, 1.f);
+      float phi = Float(0.f, PI2);
+      float r = std::sqrt(std::max(0.f, 1.f - z * z));
+      return { r * std::cos(phi), r * std::sin(phi), z };
    }
 
-   vec2 Random::Float2(vec2 min, vec2 max) {
-      return {
-         Float(min.x, max.x),
-         Float(min.y, max.y) };
+   vec2 RandomGenerator::UniformInCircle() {
+      return UniformOnCircle() * std::sqrt(Float());
    }
 
-   vec3 Random::Float3(vec3 min, vec3 max) {
-      return {
-         Float(min.x, max.x),
-         Float(min.y, max.y),
-         Float(min.z, max.z) };
+   vec2 RandomGenerator::UniformOnCircle() {
+      float phi = Float(0.f, PI2);
+      return { std::cos(phi), std::sin(phi) };
+   }
+
+   void RandomGenerator::Fill(std::span<float> out, float min, float max) {
+      constexpr u32 NLanes = 8;
+
+      // xoshiro128+ in SoA layout, lanes are independent
+      u32 s0[NLanes], s1[NLanes], s2[NLanes], s3[NLanes];
+      for (u32 lane = 0; lane < NLanes; ++lane) {
+         u64 a = U64() | 1; // state must not be zero
+         u64 b = U64();
+         s0[lane] = u32(a);
+         s1[lane] = u32(a >> 32);
+         s2[lane] = u32(b);
+         s3[lane] = u32(b >> 32);
+      }
+
+      const float scale = (max - min) * 0x1p-24f;
+
+      size_t i = 0;
+      for (; i + NLanes <= out.size(); i += NLanes) {
+         for (u32 lane = 0; lane < NLanes; ++lane) {
+            const u32 result = s0[lane] + s3[lane];
+            const u32 t = s1[lane] << 9;
+
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+
+            s2[lane] ^= t;
+            s3[lane] = (s3[lane] << 11) | (s3[lane] >> 21);
+
+            out[i + lane] = min + float(result >> 8) * scale;
+         }
+      }
+
+      for (; i < out.size(); ++i) {
+         out[i] = Float(min, max);
+      }
+   }
+
+   void RandomGenerator::Fill(std::span<vec3> out, vec3 min, vec3 max) {
+      static_assert(sizeof(vec3) == 3 * sizeof(float));
+      Fill(std::span{ &out.data()->x, out.size() * 3 });
+
+      vec3 size = max - min;
+      for (auto& v : out) {
+         v = min + v * size;
+      }
+   }
+
+   static thread_local std::optional<RandomGenerator> tGenerator;
+
+   RandomGenerator& Random::Generator() {
+      if (!tGenerator) {
+         tGenerator.emplace(RandomGenerator::NondeterministicSeed());
+      }
+      return *tGenerator;
+   }
+
+   void Random::Seed(u64 seed, u64 stream) {
+      tGenerator.emplace(seed, stream);
+   }
+
+   u32 pcg_hash(u32 input) {
+      u32 state = input * 747796405u + 2891336453u;
+      u32 word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+      return (word >> 22u) ^ word;
+   }
+
+   float Random::FloatSeeded(u32 seed) {
+      seed = pcg_hash(seed);
+      return (float)seed / (float)u32(-1);
    }
 
    Color Random::Color(u32 seed) {
@@ -53,20 +137,4 @@ namespace pbe {
       return Float3();
    }
 
-   vec3 Random::UniformInSphere() {
-      vec3 test;
-      do {
-         test = Float3(vec3{ -1 }, vec3{ 1 });
-      } while (glm::length(test) > 1);
-      return test;
-   }
-
-   vec2 Random::UniformInCircle() {
-      vec2 test;
-      do {
-         test = Float2(vec2{ -1 }, vec2{ 1 });
-      } while (glm::length(test) > 1);
-      return test;
-   }
-
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <bit>
+#include <span>
+
 #include "Types.h"
 #include "core/Core.h"
 #include "Color.h"
@@ -8,21 +11,80 @@ namespace pbe {
 
    struct Color;
 
+   // xoshiro256+ (https://prng.di.unimi.it), not cryptographic.
+   // Same seed and stream give same sequence, generator must not be shared between threads
+   class CORE_API RandomGenerator {
+   public:
+      explicit RandomGenerator(u64 seed, u64 stream = 0);
+
+      // from random_device, different per call
+      static u64 NondeterministicSeed();
+
+      u64 U64() {
+         const u64 result = s[0] + s[3];
+         const u64 t = s[1] << 17;
+
+         s[2] ^= s[0];
+         s[3] ^= s[1];
+         s[1] ^= s[2];
+         s[0] ^= s[3];
+
+         s[2] ^= t;
+         s[3] = std::rotl(s[3], 45);
+
+         return result;
+      }
+
+      u32 U32() { return u32(U64() >> 32); }
+      // [0, n)
+      u32 U32(u32 n) { return u32((u64(U32()) * n) >> 32); }
+
+      // [0, 1), high bits are the best for xoshiro+
+      float Float() { return float(U64() >> 40) * 0x1p-24f; }
+      float Float(float min, float max) { return min + Float() * (max - min); }
+      vec2 Float2(vec2 min = vec2_Zero, vec2 max = vec2_One) { return { Float(min.x, max.x), Float(min.y, max.y) }; }
+      vec3 Float3(vec3 min = vec3_Zero, vec3 max = vec3_One) {
+         return { Float(min.x, max.x), Float(min.y, max.y), Float(min.z, max.z) };
+      }
+
+      bool Bool(float trueChance = 0.5f) { return Float() < trueChance; }
+
+      // direct sampling, no rejection loops
+      vec3 UniformInSphere();
+      vec3 UniformOnSphere();
+      vec2 UniformInCircle();
+      vec2 UniformOnCircle();
+
+      // batch generation, 8 lanes of xoshiro128+ seeded from this generator, vectorized by compiler
+      void Fill(std::span<float> out, float min = 0, float max = 1);
+      void Fill(std::span<vec3> out, vec3 min = vec3_Zero, vec3 max = vec3_One);
+
+   private:
+      u64 s[4];
+   };
+
+   // uses generator of current thread, seeded nondeterministically on first use
    struct CORE_API Random {
 
+      static RandomGenerator& Generator();
+      // deterministic sequence on current thread
+      static void Seed(u64 seed, u64 stream = 0);
+
       // todo: clear up random API
       static float FloatSeeded(u32 seed);
 
-      static bool Bool(float trueChance = 0.5);
-      static float Float(float min = 0, float max = 1);
-      static vec2 Float2(vec2 min = vec2_Zero, vec2 max = vec2_One);
-      static vec3 Float3(vec3 min = vec3_Zero, vec3 max = vec3_One);
+      static bool Bool(float trueChance = 0.5) { return Generator().Bool(trueChance); }
+      static float Float(float min = 0, float max = 1) { return Generator().Float(min, max); }
+      static vec2 Float2(vec2 min = vec2_Zero, vec2 max = vec2_One) { return Generator().Float2(min, max); }
+      static vec3 Float3(vec3 min = vec3_Zero, vec3 max = vec3_One) { return Generator().Float3(min, max); }
 
-      static Color Color(u32 seed);
+      static pbe::Color Color(u32 seed);
       static pbe::Color Color();
 
-      static vec3 UniformInSphere();
-      static vec2 UniformInCircle();
+      static vec3 UniformInSphere() { return Generator().UniformInSphere(); }
+      static vec3 UniformOnSphere() { return Generator().UniformOnSphere(); }
+      static vec2 UniformInCircle() { return Generator().UniformInCircle(); }
+      static vec2 UniformOnCircle() { return Generator().UniformOnCircle(); }
 
    };
 
@@ -168,7 +168,7 @@ namespace pbe {
       }
    }
 
-   bool Frustum::PointTest(vec3 p) {
+   bool Frustum::PointTest(vec3 p) const {
       for (int i = 0; i < 6; ++i) {
          if (planes[i].Distance(p) <= 0.f) {
             return false;
@@ -178,7 +178,7 @@ namespace pbe {
       return true;
    }
 
-   bool Frustum::SphereTest(const Sphere& s) {
+   bool Frustum::SphereTest(const Sphere& s) const {
       for (int i = 0; i < 6; ++i) {
          if (planes[i].Distance(s.center) <= -s.radius) {
             return false;
@@ -87,8 +87,8 @@ namespace pbe {
 
       Frustum(const mat4& m);
 
-      bool PointTest(vec3 p);
-      bool SphereTest(const Sphere& s);
+      bool PointTest(vec3 p) const;
+      bool SphereTest(const Sphere& s) const;
    };
 
 }
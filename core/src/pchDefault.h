@@ -5,16 +5,35 @@
 #include <stack>
 #include <deque>
 #include <unordered_map>
+#include <optional>
+#include <span>
 
 #include <algorithm>
 #include <functional>
+#include <ranges>
 #include <random>
 #include <filesystem>
 
 #include <fstream>
 
-#include <d3d12.h>
-#include <dxgi1_6.h>
+#ifndef PBE_HEADLESS
+   #include <d3d12.h>
+   #include <dxgi1_6.h>
+#elif defined(_WIN32)
+   #include <windows.h>
+#else
+   // winnt.h helpers, there is no d3d12 to include them
+   #define ARRAYSIZE(a) (sizeof(a) / sizeof(a[0]))
+
+   #define DEFINE_ENUM_FLAG_OPERATORS(E) \
+      inline constexpr E operator|(E a, E b) { return E(std::underlying_type_t<E>(a) | std::underlying_type_t<E>(b)); } \
+      inline constexpr E operator&(E a, E b) { return E(std::underlying_type_t<E>(a) & std::underlying_type_t<E>(b)); } \
+      inline constexpr E operator^(E a, E b) { return E(std::underlying_type_t<E>(a) ^ std::underlying_type_t<E>(b)); } \
+      inline constexpr E operator~(E a) { return E(~std::underlying_type_t<E>(a)); } \
+      inline E& operator|=(E& a, E b) { return a = a | b; } \
+      inline E& operator&=(E& a, E b) { return a = a & b; } \
+      inline E& operator^=(E& a, E b) { return a = a ^ b; }
+#endif
 
 #include "spdlog/spdlog.h"
 #include "spdlog/fmt/ostr.h"
@@ -147,6 +147,10 @@ namespace pbe {
 
          u32 nextParentChunkIdx = replace ? chunkDescs[parentChunkIdx].parentChunkDescIndex : parentChunkIdx;
 
+         // jitter of slice planes
+         sliceOffsets.resize(slices);
+         Random::Generator().Fill(sliceOffsets, -0.5f, 0.5f);
+
          for (u32 i = 0; i <= slices; ++i) {
             u32 nextChunkIdx = (replace && i == 0) ? parentChunkIdx : chunkIdx;
             auto& chunkDesc = chunkDescs[nextChunkIdx];
@@ -157,10 +161,9 @@ namespace pbe {
             chunkDesc.centroid[1] = chunkCenter[1];
             chunkDesc.centroid[2] = chunkCenter[2];
 
-            float nextSlicePos = sliceAxisStart + chunkSliceAxisSize * (i + 1 + Random::Float(-0.5f, 0.5f) * 1.f);
-            if (i == slices) {
-               nextSlicePos = -sliceAxisStart;
-            }
+            float nextSlicePos = i == slices
+               ? -sliceAxisStart
+               : sliceAxisStart + chunkSliceAxisSize * (i + 1 + sliceOffsets[i]);
 
             chunkDesc.centroid[axis] += (slicePos + nextSlicePos) * 0.5f;
 
@@ -348,6 +351,8 @@ namespace pbe {
    private:
       std::vector<NvBlastChunkDesc> chunkDescs;
       std::vector<NvBlastBondDesc> bondDescs;
+      // scratch of Slice, reused between calls
+      std::vector<float> sliceOffsets;
 
       Transform rootTrans;
    };
@@ -6,6 +6,7 @@
 #include "PhysUtils.h"
 #include "PhysXTypeConvet.h"
 #include "DestructEventListener.h"
+#include "core/MemoryTracker.h"
 #include "core/Profiler.h"
 #include "scene/Component.h"
 #include "scene/Entity.h"
@@ -227,6 +228,7 @@ namespace pbe {
    void PhysicsScene::Simulate(float dt) {
       // todo: this called at the beginning of update, but it's better to call it at the end of update
       PROFILE_CPU("Phys simulate");
+      MEMORY_TAG(Physics);
 
       int steps = stepTimer.Update(dt);
       if (steps > 2) {
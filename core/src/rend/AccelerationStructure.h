@@ -63,7 +63,7 @@ namespace pbe {
 
          GeomDesc& geom = geoms.back();
          geom.type = GeomDesc::Type::ProceduralPrimitiveAABBs;
-         geom.aabbs = aabb;
+         geom.aabbs = std::move(aabb);
       }
 
       void AddTriangles(Ref<Buffer> vertexes, Ref<Buffer> indexes) {
@@ -74,15 +74,15 @@ namespace pbe {
 
          GeomDesc& geom = geoms.back();
          geom.type = GeomDesc::Type::Triangles;
-         geom.vertexes = vertexes;
-         geom.indexes = indexes;
+         geom.vertexes = std::move(vertexes);
+         geom.indexes = std::move(indexes);
       }
 
       void SetInstances(Ref<Buffer> instancesBuffer) {
          ASSERT(!IsBLAS());
          type = TLAS;
 
-         instances = instancesBuffer;
+         instances = std::move(instancesBuffer);
       }
 
       void Build(CommandList& cmd) {
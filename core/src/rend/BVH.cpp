@@ -1,15 +1,21 @@
 #include "pch.h"
 #include "BVH.h"
 
+#include <bit>
+
 #include "DbgRend.h"
+#include "core/JobSystem.h"
+#include "core/Profiler.h"
 #include "math/Common.h"
 #include "math/Random.h"
 #include "math/Shape.h"
+#include "utils/Algorithm.h"
 
 
 namespace pbe {
    void BVH::Build(const std::span<AABB>& aabbs, SplitMethod splitMethod) {
       nodes.clear();
+      linearNodes.clear();
 
       u32 size = (u32)aabbs.size();
       if (size == 0) {
@@ -18,7 +24,21 @@ namespace pbe {
 
       std::vector<AABBInfo> aabbInfos(size);
       for (u32 i = 0; i < size; ++i) {
-         aabbInfos[i] = AABBInfo{aabbs[i], i};
+         aabbInfos[i] = AABBInfo{aabbs[i], i, aabbs[i].Center()};
+      }
+
+      if (splitMethod == SplitMethod::BinnedSAH || splitMethod == SplitMethod::LBVH) {
+         // binary tree with one object per leaf
+         linearNodes.resize(size * 2 - 1);
+         linearParents.resize(size * 2 - 1);
+         objLinearIdx.resize(size);
+
+         if (splitMethod == SplitMethod::BinnedSAH) {
+            BuildLinearRecursive(std::span{ aabbInfos.begin(), aabbInfos.size() }, 0, UINT_MAX, 0);
+         } else {
+            BuildLBVH(aabbInfos);
+         }
+         return;
       }
 
       nodes.reserve(size * 3); // todo: not best size
@@ -26,16 +46,20 @@ namespace pbe {
    }
 
    void BVH::Flatten() {
-      linearNodes.resize(nodes.size());
       if (nodes.empty()) {
          return;
       }
 
+      linearNodes.resize(nodes.size());
+      linearParents.resize(nodes.size());
+      // each leaf holds one object, so leafs count is (nodes + 1) / 2
+      objLinearIdx.assign((nodes.size() + 1) / 2, UINT_MAX);
+
       u32 offset = 0;
       RecursiveFlatten(0, offset);
    }
 
-   u32 BVH::RecursiveFlatten(u32 nodeIdx, u32& offset) {
+   u32 BVH::RecursiveFlatten(u32 nodeIdx, u32& offset, u32 parentIdx) {
       auto& node = nodes[nodeIdx];
 
       auto& linearNode = linearNodes[offset];
@@ -43,30 +67,106 @@ namespace pbe {
       linearNode.aabbMin = node.aabb.min;
       linearNode.aabbMax = node.aabb.max;
       linearNode.objIdx = node.objIdx;
+      linearParents[currentOffset] = parentIdx;
 
       if (node.objIdx == UINT_MAX) {
-         RecursiveFlatten(node.children[0], offset);
+         RecursiveFlatten(node.children[0], offset, currentOffset);
          linearNode.secondChildOffset = offset;
-         RecursiveFlatten(node.children[1], offset);
+         RecursiveFlatten(node.children[1], offset, currentOffset);
+      } else {
+         objLinearIdx[node.objIdx] = currentOffset;
       }
 
       return currentOffset;
    }
 
+   void BVH::Refit(std::span<const AABB> aabbs) {
+      ASSERT(aabbs.size() == objLinearIdx.size());
+
+      // depth first order: children always placed after parent
+      for (u32 i = (u32)linearNodes.size(); i > 0; --i) {
+         auto& node = linearNodes[i - 1];
+
+         if (node.objIdx != UINT_MAX) {
+            auto& aabb = aabbs[node.objIdx];
+            node.aabbMin = aabb.min;
+            node.aabbMax = aabb.max;
+         } else {
+            auto& left = linearNodes[i];
+            auto& right = linearNodes[node.secondChildOffset];
+            node.aabbMin = glm::min(left.aabbMin, right.aabbMin);
+            node.aabbMax = glm::max(left.aabbMax, right.aabbMax);
+         }
+      }
+   }
+
+   void BVH::Refit(std::span<const AABB> aabbs, std::span<const u32> changedObjIdxs) {
+      ASSERT(aabbs.size() == objLinearIdx.size());
+
+      for (u32 objIdx : changedObjIdxs) {
+         u32 nodeIdx = objLinearIdx[objIdx];
+
+         auto& aabb = aabbs[objIdx];
+         auto& leaf = linearNodes[nodeIdx];
+         leaf.aabbMin = aabb.min;
+         leaf.aabbMax = aabb.max;
+
+         for (u32 parentIdx = linearParents[nodeIdx]; parentIdx != UINT_MAX; parentIdx = linearParents[parentIdx]) {
+            auto& node = linearNodes[parentIdx];
+            auto& left = linearNodes[parentIdx + 1];
+            auto& right = linearNodes[node.secondChildOffset];
+
+            vec3 aabbMin = glm::min(left.aabbMin, right.aabbMin);
+            vec3 aabbMax = glm::max(left.aabbMax, right.aabbMax);
+
+            // parents above already contain this bounds
+            if (aabbMin == node.aabbMin && aabbMax == node.aabbMax) {
+               break;
+            }
+
+            node.aabbMin = aabbMin;
+            node.aabbMax = aabbMax;
+         }
+      }
+   }
+
+   float BVH::SAHCost() const {
+      if (linearNodes.empty()) {
+         return 0;
+      }
+
+      auto nodeArea = [](const BVHNode& node) {
+         return AABB::FromMinMax(node.aabbMin, node.aabbMax).Area();
+      };
+
+      float rootArea = nodeArea(linearNodes[0]);
+      if (rootArea <= 0) {
+         return 0;
+      }
+
+      // traversal and intersection costs are equal
+      float cost = 0;
+      for (auto& node : linearNodes) {
+         cost += nodeArea(node);
+      }
+
+      return cost / rootArea;
+   }
+
    void BVH::Render(DbgRend& dbgRend, u32 showLevel, u32 nodeIdx, u32 level) {
-      if (nodeIdx == UINT_MAX || nodes.empty()) {
+      if (nodeIdx >= linearNodes.size()) {
          return;
       }
 
-      auto& node = nodes[nodeIdx];
+      auto& node = linearNodes[nodeIdx];
 
       if (showLevel == -1 || showLevel == level) {
-         dbgRend.DrawAABB(nullptr, node.aabb, Random::Color(level));
+         dbgRend.DrawAABB(nullptr, AABB::FromMinMax(node.aabbMin, node.aabbMax), Random::Color(level));
       }
 
       if (node.objIdx == UINT_MAX) {
-         Render(dbgRend, showLevel, node.children[0], level + 1);
-         Render(dbgRend, showLevel, node.children[1], level + 1);
+         Render(dbgRend, showLevel, nodeIdx + 1, level + 1);
+         Render(dbgRend, showLevel, node.secondChildOffset, level + 1);
       }
    }
 
@@ -114,6 +214,12 @@ namespace pbe {
       case SplitMethod::EqualCounts:
          SplitEqualCount();
          break;
+      case SplitMethod::BinnedSAH:
+      case SplitMethod::LBVH:
+         // built directly into linear nodes
+         ASSERT(false);
+         SplitEqualCount();
+         break;
       case SplitMethod::SAH:
          if (count <= 2) {
             mid = count / 2;
@@ -207,4 +313,432 @@ namespace pbe {
 
       return buildNodeIdx;
    }
+
+   // returns objects count in left part or 0 if split not found
+   static u32 SplitBinnedSAH(std::span<BVH::AABBInfo> aabbInfos, const AABB& centroidBounds, u32 nBins) {
+      // vec3 is not initialized by default, only first nBins are cleared below
+      struct Bin {
+         vec3 min;
+         vec3 max;
+         u32 count;
+      };
+
+      Bin bins[3][BVH::MaxBins];
+      for (int axis = 0; axis < 3; ++axis) {
+         for (u32 i = 0; i < nBins; ++i) {
+            bins[axis][i] = Bin{ vec3{ FLT_MAX }, vec3{ -FLT_MAX }, 0 };
+         }
+      }
+
+      vec3 extent = centroidBounds.max - centroidBounds.min;
+      vec3 scale;
+      for (int axis = 0; axis < 3; ++axis) {
+         scale[axis] = extent[axis] > 0 ? (float)nBins / extent[axis] : 0;
+      }
+
+      auto BinIdx = [&](const vec3& center, int axis) {
+         return std::min((u32)((center[axis] - centroidBounds.min[axis]) * scale[axis]), nBins - 1);
+      };
+
+      for (auto& aabbInfo : aabbInfos) {
+         for (int axis = 0; axis < 3; ++axis) {
+            auto& bin = bins[axis][BinIdx(aabbInfo.center, axis)];
+            bin.min = glm::min(bin.min, aabbInfo.aabb.min);
+            bin.max = glm::max(bin.max, aabbInfo.aabb.max);
+            bin.count++;
+         }
+      }
+
+      auto Area = [](const vec3& min, const vec3& max) {
+         vec3 s = glm::max(max - min, vec3_Zero);
+         return s.x * s.y + s.x * s.z + s.y * s.z;
+      };
+
+      float minCost = FLT_MAX;
+      int splitAxis = -1;
+      u32 splitBin = 0;
+
+      for (int axis = 0; axis < 3; ++axis) {
+         if (extent[axis] <= 0) {
+            continue;
+         }
+
+         // suffix sweep: bounds and count of bins [i, nBins)
+         float rightArea[BVH::MaxBins];
+         u32 rightCount[BVH::MaxBins];
+
+         vec3 min{ FLT_MAX };
+         vec3 max{ -FLT_MAX };
+         u32 count = 0;
+         for (u32 i = nBins - 1; i > 0; --i) {
+            auto& bin = bins[axis][i];
+            min = glm::min(min, bin.min);
+            max = glm::max(max, bin.max);
+            count += bin.count;
+            rightArea[i] = Area(min, max);
+            rightCount[i] = count;
+         }
+
+         // prefix sweep: bounds and count of bins [0, i]
+         min = vec3{ FLT_MAX };
+         max = vec3{ -FLT_MAX };
+         count = 0;
+         for (u32 i = 0; i < nBins - 1; ++i) {
+            auto& bin = bins[axis][i];
+            min = glm::min(min, bin.min);
+            max = glm::max(max, bin.max);
+            count += bin.count;
+            if (count == 0 || rightCount[i + 1] == 0) {
+               continue;
+            }
+
+            float cost = (float)count * Area(min, max) + (float)rightCount[i + 1] * rightArea[i + 1];
+            if (cost < minCost) {
+               minCost = cost;
+               splitAxis = axis;
+               splitBin = i;
+            }
+         }
+      }
+
+      if (splitAxis == -1) {
+         return 0;
+      }
+
+      auto it = std::ranges::partition(aabbInfos,
+         [&](const BVH::AABBInfo& a) { return BinIdx(a.center, splitAxis) <= splitBin; });
+      return (u32)(aabbInfos.size() - it.size());
+   }
+
+   void BVH::BuildLinearRecursive(std::span<AABBInfo> aabbInfos, u32 nodeIdx, u32 parentIdx, u32 depth) {
+      u32 count = (u32)aabbInfos.size();
+      ASSERT(count > 0);
+
+      auto& linearNode = linearNodes[nodeIdx];
+      linearParents[nodeIdx] = parentIdx;
+
+      AABB bounds = AABB::Empty();
+      AABB centroidBounds = AABB::Empty();
+      for (auto& aabbInfo : aabbInfos) {
+         bounds.AddAABB(aabbInfo.aabb);
+         centroidBounds.AddPoint(aabbInfo.center);
+      }
+
+      linearNode.aabbMin = bounds.min;
+      linearNode.aabbMax = bounds.max;
+
+      if (count == 1) {
+         linearNode.objIdx = aabbInfos[0].idx;
+         linearNode.secondChildOffset = 0;
+         objLinearIdx[linearNode.objIdx] = nodeIdx;
+         return;
+      }
+
+      // small nodes dont need many bins
+      u32 nodeBins = std::clamp(std::min(nBins, count), 2u, MaxBins);
+      u32 mid = SplitBinnedSAH(aabbInfos, centroidBounds, nodeBins);
+      if (mid == 0) {
+         // all centroids are in the same point, any split is equal
+         mid = count / 2;
+      }
+
+      // depth first: left subtree follows the node and takes 2 * mid - 1 nodes
+      u32 leftIdx = nodeIdx + 1;
+      u32 rightIdx = nodeIdx + 2 * mid;
+
+      linearNode.objIdx = UINT_MAX;
+      linearNode.secondChildOffset = rightIdx;
+
+      auto left = aabbInfos.first(mid);
+      auto right = aabbInfos.subspan(mid);
+
+      constexpr u32 minParallelCount = 1024;
+      if (depth < parallelDepth && count >= minParallelCount) {
+         auto& jobSystem = JobSystem::Get();
+         JobCounter leftCounter;
+         jobSystem.Run("BVH build subtree", [&] { BuildLinearRecursive(left, leftIdx, nodeIdx, depth + 1); }, &leftCounter);
+         BuildLinearRecursive(right, rightIdx, nodeIdx, depth + 1);
+         jobSystem.Wait(leftCounter);
+      } else {
+         BuildLinearRecursive(left, leftIdx, nodeIdx, depth + 1);
+         BuildLinearRecursive(right, rightIdx, nodeIdx, depth + 1);
+      }
+   }
+
+   // 10 bits -> 30 bits, two zero bits between each input bit
+   static u32 ExpandBits10(u32 v) {
+      v = (v * 0x00010001u) & 0xFF0000FFu;
+      v = (v * 0x00000101u) & 0x0F00F00Fu;
+      v = (v * 0x00000011u) & 0xC30C30C3u;
+      v = (v * 0x00000005u) & 0x49249249u;
+      return v;
+   }
+
+   // 21 bits -> 63 bits
+   static u64 ExpandBits21(u64 v) {
+      v &= 0x1FFFFF;
+      v = (v | v << 32) & 0x1F00000000FFFFull;
+      v = (v | v << 16) & 0x1F0000FF0000FFull;
+      v = (v | v << 8) & 0x100F00F00F00F00Full;
+      v = (v | v << 4) & 0x10C30C30C30C30C3ull;
+      v = (v | v << 2) & 0x1249249249249249ull;
+      return v;
+   }
+
+   // p in [0, 1]
+   static u64 MortonCode(const vec3& p, bool morton64) {
+      if (morton64) {
+         constexpr float scale = (float)(1 << 21) - 1;
+         return (ExpandBits21((u64)(p.x * scale)) << 2)
+            | (ExpandBits21((u64)(p.y * scale)) << 1)
+            | ExpandBits21((u64)(p.z * scale));
+      }
+
+      constexpr float scale = 1023.f;
+      return (ExpandBits10((u32)(p.x * scale)) << 2)
+         | (ExpandBits10((u32)(p.y * scale)) << 1)
+         | ExpandBits10((u32)(p.z * scale));
+   }
+
+   // last object idx of left part. Objects [0, split] have the same highest differing bit
+   static u32 FindMortonSplit(std::span<const u64> codes) {
+      u32 last = (u32)codes.size() - 1;
+
+      u64 firstCode = codes[0];
+      u64 lastCode = codes[last];
+      if (firstCode == lastCode) {
+         return last / 2;
+      }
+
+      int commonPrefix = std::countl_zero(firstCode ^ lastCode);
+
+      // binary search of the last code that shares more than commonPrefix bits with the first one
+      u32 split = 0;
+      u32 step = last;
+      do {
+         step = (step + 1) >> 1;
+         u32 newSplit = split + step;
+
+         if (newSplit < last && std::countl_zero(firstCode ^ codes[newSplit]) > commonPrefix) {
+            split = newSplit;
+         }
+      } while (step > 1);
+
+      return split;
+   }
+
+   void BVH::BuildLBVH(std::span<AABBInfo> aabbInfos) {
+      u32 size = (u32)aabbInfos.size();
+
+      AABB centroidBounds = AABB::Empty();
+      for (auto& aabbInfo : aabbInfos) {
+         centroidBounds.AddPoint(aabbInfo.center);
+      }
+
+      vec3 extent = centroidBounds.max - centroidBounds.min;
+      vec3 scale = glm::max(extent, vec3{ FLT_MIN });
+      scale = 1.f / scale;
+
+      std::vector<u64> codes(size);
+      std::vector<u32> order(size);
+      for (u32 i = 0; i < size; ++i) {
+         vec3 p = Saturate((aabbInfos[i].center - centroidBounds.min) * scale);
+         codes[i] = MortonCode(p, lbvhMorton64);
+         order[i] = i;
+      }
+
+      RadixSort(codes, order, lbvhMorton64 ? 63 : 30);
+
+      std::vector<AABBInfo> sortedInfos(size);
+      for (u32 i = 0; i < size; ++i) {
+         sortedInfos[i] = aabbInfos[order[i]];
+      }
+
+      BuildLBVHRecursive(sortedInfos, codes, 0, UINT_MAX, 0);
+   }
+
+   void BVH::BuildLBVHRecursive(std::span<AABBInfo> aabbInfos, std::span<const u64> codes, u32 nodeIdx, u32 parentIdx, u32 depth) {
+      u32 count = (u32)aabbInfos.size();
+      ASSERT(count > 0);
+
+      if (count <= lbvhTreeletSize && count > 2) {
+         BuildLinearRecursive(aabbInfos, nodeIdx, parentIdx, depth);
+         return;
+      }
+
+      auto& linearNode = linearNodes[nodeIdx];
+      linearParents[nodeIdx] = parentIdx;
+
+      if (count == 1) {
+         linearNode.aabbMin = aabbInfos[0].aabb.min;
+         linearNode.aabbMax = aabbInfos[0].aabb.max;
+         linearNode.objIdx = aabbInfos[0].idx;
+         linearNode.secondChildOffset = 0;
+         objLinearIdx[linearNode.objIdx] = nodeIdx;
+         return;
+      }
+
+      u32 mid = FindMortonSplit(codes) + 1;
+
+      u32 leftIdx = nodeIdx + 1;
+      u32 rightIdx = nodeIdx + 2 * mid;
+
+      linearNode.objIdx = UINT_MAX;
+      linearNode.secondChildOffset = rightIdx;
+
+      constexpr u32 minParallelCount = 1024;
+      if (depth < parallelDepth && count >= minParallelCount) {
+         auto& jobSystem = JobSystem::Get();
+         JobCounter leftCounter;
+         jobSystem.Run("LBVH build subtree", [&] { BuildLBVHRecursive(aabbInfos.first(mid), codes.first(mid), leftIdx, nodeIdx, depth + 1); }, &leftCounter);
+         BuildLBVHRecursive(aabbInfos.subspan(mid), codes.subspan(mid), rightIdx, nodeIdx, depth + 1);
+         jobSystem.Wait(leftCounter);
+      } else {
+         BuildLBVHRecursive(aabbInfos.first(mid), codes.first(mid), leftIdx, nodeIdx, depth + 1);
+         BuildLBVHRecursive(aabbInfos.subspan(mid), codes.subspan(mid), rightIdx, nodeIdx, depth + 1);
+      }
+
+      // bounds from children, objects are not visited again
+      auto& left = linearNodes[leftIdx];
+      auto& right = linearNodes[rightIdx];
+      linearNode.aabbMin = glm::min(left.aabbMin, right.aabbMin);
+      linearNode.aabbMax = glm::max(left.aabbMax, right.aabbMax);
+   }
+
+   template<u32 Width>
+   void WideBVH<Width>::Collapse(std::span<const BVHNode> binaryNodes) {
+      nodes.clear();
+      if (binaryNodes.empty()) {
+         return;
+      }
+
+      // each wide node replaces at least Width - 1 binary inner nodes
+      nodes.reserve(binaryNodes.size() / (2 * (Width - 1)) + 1);
+
+      if (binaryNodes[0].objIdx == UINT_MAX) {
+         CollapseRecursive(binaryNodes, 0);
+         return;
+      }
+
+      // single object
+      auto& root = binaryNodes[0];
+
+      WideBVHNode<Width> node;
+      for (u32 i = 0; i < Width; ++i) {
+         node.minX[i] = node.minY[i] = node.minZ[i] = FLT_MAX;
+         node.maxX[i] = node.maxY[i] = node.maxZ[i] = -FLT_MAX;
+         node.children[i] = UINT_MAX;
+      }
+
+      node.minX[0] = root.aabbMin.x;
+      node.minY[0] = root.aabbMin.y;
+      node.minZ[0] = root.aabbMin.z;
+      node.maxX[0] = root.aabbMax.x;
+      node.maxY[0] = root.aabbMax.y;
+      node.maxZ[0] = root.aabbMax.z;
+      node.children[0] = root.objIdx | BVH_WIDE_LEAF;
+
+      nodes.push_back(node);
+   }
+
+   template<u32 Width>
+   u32 WideBVH<Width>::CollapseRecursive(std::span<const BVHNode> binaryNodes, u32 binaryIdx) {
+      auto& binaryNode = binaryNodes[binaryIdx];
+      ASSERT(binaryNode.objIdx == UINT_MAX);
+
+      u32 lanes[Width];
+      u32 nLanes = 0;
+      lanes[nLanes++] = binaryIdx + 1;
+      lanes[nLanes++] = binaryNode.secondChildOffset;
+
+      // open inner child with largest area until all lanes are used
+      while (nLanes < Width) {
+         int bestLane = -1;
+         float bestArea = -1;
+
+         for (u32 i = 0; i < nLanes; ++i) {
+            auto& child = binaryNodes[lanes[i]];
+            if (child.objIdx != UINT_MAX) {
+               continue;
+            }
+
+            float area = AABB::FromMinMax(child.aabbMin, child.aabbMax).Area();
+            if (area > bestArea) {
+               bestArea = area;
+               bestLane = i;
+            }
+         }
+
+         if (bestLane == -1) {
+            break;
+         }
+
+         u32 openIdx = lanes[bestLane];
+         lanes[bestLane] = openIdx + 1;
+         lanes[nLanes++] = binaryNodes[openIdx].secondChildOffset;
+      }
+
+      u32 wideIdx = (u32)nodes.size();
+      nodes.emplace_back();
+
+      WideBVHNode<Width> node;
+      for (u32 i = 0; i < Width; ++i) {
+         if (i >= nLanes) {
+            node.minX[i] = node.minY[i] = node.minZ[i] = FLT_MAX;
+            node.maxX[i] = node.maxY[i] = node.maxZ[i] = -FLT_MAX;
+            node.children[i] = UINT_MAX;
+            continue;
+         }
+
+         auto& child = binaryNodes[lanes[i]];
+
+         node.minX[i] = child.aabbMin.x;
+         node.minY[i] = child.aabbMin.y;
+         node.minZ[i] = child.aabbMin.z;
+         node.maxX[i] = child.aabbMax.x;
+         node.maxY[i] = child.aabbMax.y;
+         node.maxZ[i] = child.aabbMax.z;
+
+         if (child.objIdx != UINT_MAX) {
+            ASSERT((child.objIdx & BVH_WIDE_LEAF) == 0);
+            node.children[i] = child.objIdx | BVH_WIDE_LEAF;
+         } else {
+            node.children[i] = CollapseRecursive(binaryNodes, lanes[i]);
+         }
+      }
+
+      // recursion reallocates nodes, so write by index at the end
+      nodes[wideIdx] = node;
+
+      return wideIdx;
+   }
+
+   template struct WideBVH<4>;
+   template struct WideBVH<8>;
+
+   void BVHBuildBenchmark(u32 nAabbs, u32 nIterations) {
+      std::vector<AABB> aabbs(nAabbs);
+      for (auto& aabb : aabbs) {
+         aabb = AABB::FromSize(Random::Float3(vec3{ -100 }, vec3{ 100 }), Random::Float3(vec3{ 0.1f }, vec3{ 2 }));
+      }
+
+      auto Bench = [&](const char* name, BVH::SplitMethod splitMethod) {
+         BVH bvh;
+
+         CpuTimer timer;
+         for (u32 i = 0; i < nIterations; ++i) {
+            bvh.Build(aabbs, splitMethod);
+            bvh.Flatten();
+         }
+         float buildMs = timer.ElapsedMs() / (float)nIterations;
+
+         INFO("BVH benchmark {}: {} aabbs, build {:.3f} ms, SAH cost {:.2f}", name, nAabbs, buildMs, bvh.SAHCost());
+      };
+
+      Bench("Middle", BVH::SplitMethod::Middle);
+      Bench("EqualCounts", BVH::SplitMethod::EqualCounts);
+      Bench("SAH", BVH::SplitMethod::SAH);
+      Bench("BinnedSAH", BVH::SplitMethod::BinnedSAH);
+      Bench("LBVH", BVH::SplitMethod::LBVH);
+   }
 }
@@ -12,8 +12,12 @@ namespace pbe {
          Middle,
          EqualCounts,
          SAH,
+         BinnedSAH,
+         LBVH,
       };
 
+      static constexpr u32 MaxBins = 32;
+
       struct BuildNode {
          AABB aabb;
          u32 children[2] = {UINT_MAX, UINT_MAX};
@@ -23,19 +27,83 @@ namespace pbe {
       struct AABBInfo {
          AABB aabb;
          u32 idx;
+         vec3 center;
       };
 
+      // BinnedSAH settings
+      u32 nBins = 16; // per axis, up to MaxBins
+      u32 parallelDepth = 4; // top tree levels build one subtree in JobSystem job
+
+      // LBVH settings
+      bool lbvhMorton64 = false; // 63 bit morton codes instead of 30 bit
+      u32 lbvhTreeletSize = 8; // subtrees with this or less objects are rebuilt with BinnedSAH, 0 - pure LBVH
+
+      // BinnedSAH and LBVH build linearNodes directly and leaves nodes empty
       std::vector<BuildNode> nodes;
       std::vector<BVHNode> linearNodes;
 
+      // filled by Flatten or direct linear build, used by Refit
+      std::vector<u32> linearParents;
+      std::vector<u32> objLinearIdx;
+
       void Build(const std::span<AABB>& aabbs, SplitMethod splitMethod = SplitMethod::SAH);
 
+      // convert nodes to depth first linearNodes. No op if tree was built directly to linearNodes
       void Flatten();
-      u32 RecursiveFlatten(u32 nodeIdx, u32& offset);
+      u32 RecursiveFlatten(u32 nodeIdx, u32& offset, u32 parentIdx = UINT_MAX);
+
+      // update linearNodes bounds without changing topology. Objects count must be the same as in Build
+      void Refit(std::span<const AABB> aabbs);
+      // update only leafs of changed objects and their parents
+      void Refit(std::span<const AABB> aabbs, std::span<const u32> changedObjIdxs);
+
+      // SAH cost of linearNodes normalized by root area. Grows when refit degrades tree quality
+      float SAHCost() const;
 
       void Render(DbgRend& dbgRend, u32 showLevel = -1, u32 nodeIdx = 0, u32 level = 0);
 
    private:
       u32 BuildRecursive(std::span<AABBInfo> aabbInfos, SplitMethod splitMethod);
+      // writes subtree to linearNodes starting from nodeIdx. Subtree with n objects takes 2n - 1 nodes,
+      // so child offsets are known before children are built
+      void BuildLinearRecursive(std::span<AABBInfo> aabbInfos, u32 nodeIdx, u32 parentIdx, u32 depth);
+      void BuildLBVH(std::span<AABBInfo> aabbInfos);
+      // same layout as BuildLinearRecursive, aabbInfos are sorted by morton codes and split at highest differing bit
+      void BuildLBVHRecursive(std::span<AABBInfo> aabbInfos, std::span<const u64> codes, u32 nodeIdx, u32 parentIdx, u32 depth);
+   };
+
+   // same memory layout as BVH4Node from rt.hlsli for Width = 4
+   template<u32 Width>
+   struct WideBVHNode {
+      float minX[Width];
+      float minY[Width];
+      float minZ[Width];
+      float maxX[Width];
+      float maxY[Width];
+      float maxZ[Width];
+      u32 children[Width];
    };
+
+   static_assert(sizeof(WideBVHNode<4>) == sizeof(BVH4Node));
+
+   // binary bvh collapsed to Width children per node, so all children are tested with one simd instruction
+   template<u32 Width>
+   struct WideBVH {
+      std::vector<WideBVHNode<Width>> nodes;
+
+      // binaryNodes - BVH::linearNodes
+      void Collapse(std::span<const BVHNode> binaryNodes);
+
+   private:
+      u32 CollapseRecursive(std::span<const BVHNode> binaryNodes, u32 binaryIdx);
+   };
+
+   extern template struct WideBVH<4>;
+   extern template struct WideBVH<8>;
+
+   using BVH4 = WideBVH<4>;
+   using BVH8 = WideBVH<8>;
+
+   // build 'nAabbs' random aabbs with every split method and log build time and SAH cost
+   void BVHBuildBenchmark(u32 nAabbs, u32 nIterations = 5);
 }
@@ -0,0 +1,690 @@
+#include "pch.h"
+#include "BVHTracer.h"
+
+#include <bit>
+#include <immintrin.h>
+
+#include "core/Assert.h"
+#include "core/Profiler.h"
+#include "math/Random.h"
+
+
+namespace pbe {
+
+   // same as CreateRayHit in intersection.hlsli
+   constexpr float TRACE_T_MIN = 0.00001f;
+   constexpr u32 TRACE_STACK_SIZE = 128;
+
+   // traversal stack in local memory, moves to heap if tree is too deep for it
+   template<typename T>
+   struct TraceStack {
+      TraceStack() = default;
+      TraceStack(const TraceStack&) = delete;
+      TraceStack& operator=(const TraceStack&) = delete;
+
+      void Push(const T& entry) {
+         if (size == capacity) [[unlikely]] {
+            Grow();
+         }
+         entries[size++] = entry;
+      }
+
+      T Pop() { return entries[--size]; }
+      bool Empty() const { return size == 0; }
+
+   private:
+      T localEntries[TRACE_STACK_SIZE];
+      std::vector<T> heapEntries;
+      T* entries = localEntries;
+      u32 capacity = TRACE_STACK_SIZE;
+      u32 size = 0;
+
+      void Grow() {
+         if (heapEntries.empty()) {
+            heapEntries.assign(localEntries, localEntries + size);
+         }
+         capacity *= 2;
+         heapEntries.resize(capacity);
+         entries = heapEntries.data();
+      }
+   };
+
+   static bool IntersectSphere(const Ray& ray, TraceHit& hit, const vec3& center, float radius) {
+      vec3 d = ray.origin - center;
+      float p1 = -glm::dot(ray.direction, d);
+      float p2sqr = p1 * p1 - glm::dot(d, d) + radius * radius;
+      if (p2sqr < 0) {
+         return false;
+      }
+
+      float p2 = sqrt(p2sqr);
+      float t = p1 - p2 > 0 ? p1 - p2 : p1 + p2;
+      if (t > TRACE_T_MIN && t < hit.tMax) {
+         hit.tMax = t;
+         hit.position = ray.origin + t * ray.direction;
+         hit.normal = glm::normalize(hit.position - center);
+         return true;
+      }
+      return false;
+   }
+
+   // box centered in origin
+   static bool IntersectAABB(const Ray& ray, TraceHit& hit, const vec3& halfSize) {
+      vec3 tMin = (-halfSize - ray.origin) / ray.direction;
+      vec3 tMax = (halfSize - ray.origin) / ray.direction;
+      vec3 t1 = glm::min(tMin, tMax);
+      vec3 t2 = glm::max(tMin, tMax);
+      float tNear = glm::max(glm::max(t1.x, t1.y), t1.z);
+      float tFar = glm::min(glm::min(t2.x, t2.y), t2.z);
+
+      if (tFar > tNear && tNear > TRACE_T_MIN && tNear < hit.tMax) {
+         hit.tMax = tNear;
+         hit.position = ray.origin + tNear * ray.direction;
+
+         vec3 normal = hit.position / halfSize;
+         vec3 s = glm::sign(normal);
+         normal *= s;
+
+         vec3 normalXY = normal.x > normal.y ? vec3{ s.x, 0, 0 } : vec3{ 0, s.y, 0 };
+         hit.normal = normal.z > glm::max(normal.x, normal.y) ? vec3{ 0, 0, s.z } : normalXY;
+
+         return true;
+      }
+      return false;
+   }
+
+   static bool IntersectOBB(const Ray& ray, TraceHit& hit, const vec3& center, const quat& rotation, const vec3& halfSize) {
+      quat rotationInv = glm::conjugate(rotation);
+      Ray rayL{ rotationInv * (ray.origin - center), rotationInv * ray.direction };
+
+      if (IntersectAABB(rayL, hit, halfSize)) {
+         hit.position = rotation * hit.position + center;
+         hit.normal = rotation * hit.normal;
+         return true;
+      }
+
+      return false;
+   }
+
+   // slab test, returns entry distance or FLT_MAX on miss
+   static float IntersectNode(const vec3& origin, const vec3& invDirection, const BVHNode& node) {
+      vec3 tMin = (node.aabbMin - origin) * invDirection;
+      vec3 tMax = (node.aabbMax - origin) * invDirection;
+      vec3 t1 = glm::min(tMin, tMax);
+      vec3 t2 = glm::max(tMin, tMax);
+      float tNear = glm::max(glm::max(t1.x, t1.y), t1.z);
+      float tFar = glm::min(glm::min(t2.x, t2.y), t2.z);
+
+      if (tFar >= tNear && tFar > 0) {
+         return tNear;
+      }
+      return FLT_MAX;
+   }
+
+   BVHTracer::BVHTracer(std::span<const BVHNode> nodes, std::span<const SRTObject> objs)
+      : nodes(nodes), objs(objs) {
+   }
+
+   bool BVHTracer::IntersectObj(const Ray& ray, const SRTObject& obj, u32 objIdx, TraceHit& hit) {
+      // SRTObject stores quat in glm memory order (w, x, y, z)
+      bool intersect = obj.geomType == 1
+         ? IntersectOBB(ray, hit, obj.position, quat{ obj.rotation.x, obj.rotation.y, obj.rotation.z, obj.rotation.w }, obj.halfSize)
+         : IntersectSphere(ray, hit, obj.position, obj.halfSize.x);
+
+      if (intersect) {
+         hit.objIdx = objIdx;
+      }
+      return intersect;
+   }
+
+   TraceHit BVHTracer::ClosestHit(const Ray& ray, float tMax, TraceStats* stats) const {
+      TraceHit hit;
+      hit.tMax = tMax;
+
+      if (nodes.empty()) {
+         return hit;
+      }
+
+      vec3 invDirection = 1.f / ray.direction;
+
+      struct StackEntry {
+         u32 nodeIdx;
+         float tNear;
+      };
+
+      TraceStack<StackEntry> stack;
+
+      if (IntersectNode(ray.origin, invDirection, nodes[0]) < hit.tMax) {
+         stack.Push({ 0, 0 });
+      }
+
+      while (!stack.Empty()) {
+         auto [iNode, tNear] = stack.Pop();
+         // node was pushed before closer hit was found
+         if (tNear >= hit.tMax) {
+            continue;
+         }
+
+         while (true) {
+            if (stats) {
+               stats->nodesVisited++;
+            }
+
+            const BVHNode& node = nodes[iNode];
+
+            if (node.objIdx != UINT_MAX) {
+               if (stats) {
+                  stats->objsTested++;
+               }
+
+               IntersectObj(ray, objs[node.objIdx], node.objIdx, hit);
+               break;
+            }
+
+            u32 iLeft = iNode + 1;
+            u32 iRight = node.secondChildOffset;
+
+            float tLeft = IntersectNode(ray.origin, invDirection, nodes[iLeft]);
+            float tRight = IntersectNode(ray.origin, invDirection, nodes[iRight]);
+            bool intersectL = tLeft < hit.tMax;
+            bool intersectR = tRight < hit.tMax;
+
+            if (intersectL && intersectR) {
+               // visit nearest node first
+               if (tRight < tLeft) {
+                  std::swap(iLeft, iRight);
+                  std::swap(tLeft, tRight);
+               }
+
+               stack.Push({ iRight, tRight });
+               iNode = iLeft;
+            } else if (intersectL) {
+               iNode = iLeft;
+            } else if (intersectR) {
+               iNode = iRight;
+            } else {
+               break;
+            }
+         }
+      }
+
+      return hit;
+   }
+
+   bool BVHTracer::AnyHit(const Ray& ray, float tMax, TraceStats* stats) const {
+      if (nodes.empty()) {
+         return false;
+      }
+
+      vec3 invDirection = 1.f / ray.direction;
+
+      TraceHit hit;
+      hit.tMax = tMax;
+
+      TraceStack<u32> stack;
+
+      if (IntersectNode(ray.origin, invDirection, nodes[0]) < tMax) {
+         stack.Push(0);
+      }
+
+      while (!stack.Empty()) {
+         u32 iNode = stack.Pop();
+
+         if (stats) {
+            stats->nodesVisited++;
+         }
+
+         const BVHNode& node = nodes[iNode];
+
+         if (node.objIdx != UINT_MAX) {
+            if (stats) {
+               stats->objsTested++;
+            }
+
+            if (IntersectObj(ray, objs[node.objIdx], node.objIdx, hit)) {
+               return true;
+            }
+            continue;
+         }
+
+         u32 iLeft = iNode + 1;
+         u32 iRight = node.secondChildOffset;
+
+         if (IntersectNode(ray.origin, invDirection, nodes[iRight]) < tMax) {
+            stack.Push(iRight);
+         }
+         if (IntersectNode(ray.origin, invDirection, nodes[iLeft]) < tMax) {
+            stack.Push(iLeft);
+         }
+      }
+
+      return false;
+   }
+
+   // thin simd wrappers, so packet traversal is written once for 4 and 8 rays
+   struct Float4 {
+      static constexpr u32 Width = 4;
+      __m128 v;
+
+      static Float4 Set1(float f) { return { _mm_set1_ps(f) }; }
+      static Float4 Load(const float* p) { return { _mm_loadu_ps(p) }; }
+      void Store(float* p) const { _mm_storeu_ps(p, v); }
+
+      friend Float4 operator-(Float4 a, Float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+      friend Float4 operator*(Float4 a, Float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+      friend Float4 Min(Float4 a, Float4 b) { return { _mm_min_ps(a.v, b.v) }; }
+      friend Float4 Max(Float4 a, Float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+      // bit per lane
+      friend u32 MaskLessEqual(Float4 a, Float4 b) { return (u32)_mm_movemask_ps(_mm_cmple_ps(a.v, b.v)); }
+   };
+
+#ifdef __AVX__
+   struct Float8 {
+      static constexpr u32 Width = 8;
+      __m256 v;
+
+      static Float8 Set1(float f) { return { _mm256_set1_ps(f) }; }
+      static Float8 Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+      void Store(float* p) const { _mm256_storeu_ps(p, v); }
+
+      friend Float8 operator-(Float8 a, Float8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+      friend Float8 operator*(Float8 a, Float8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+      friend Float8 Min(Float8 a, Float8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+      friend Float8 Max(Float8 a, Float8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+      friend u32 MaskLessEqual(Float8 a, Float8 b) { return (u32)_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)); }
+   };
+#else
+   // no avx in this build, two sse registers
+   struct Float8 {
+      static constexpr u32 Width = 8;
+      Float4 lo;
+      Float4 hi;
+
+      static Float8 Set1(float f) { return { Float4::Set1(f), Float4::Set1(f) }; }
+      static Float8 Load(const float* p) { return { Float4::Load(p), Float4::Load(p + 4) }; }
+      void Store(float* p) const { lo.Store(p); hi.Store(p + 4); }
+
+      friend Float8 operator-(Float8 a, Float8 b) { return { a.lo - b.lo, a.hi - b.hi }; }
+      friend Float8 operator*(Float8 a, Float8 b) { return { a.lo * b.lo, a.hi * b.hi }; }
+      friend Float8 Min(Float8 a, Float8 b) { return { Min(a.lo, b.lo), Min(a.hi, b.hi) }; }
+      friend Float8 Max(Float8 a, Float8 b) { return { Max(a.lo, b.lo), Max(a.hi, b.hi) }; }
+      friend u32 MaskLessEqual(Float8 a, Float8 b) { return MaskLessEqual(a.lo, b.lo) | (MaskLessEqual(a.hi, b.hi) << 4); }
+   };
+#endif
+
+   template<u32 Width>
+   struct FloatForWidth;
+
+   template<>
+   struct FloatForWidth<4> {
+      using Type = Float4;
+   };
+
+   template<>
+   struct FloatForWidth<8> {
+      using Type = Float8;
+   };
+
+   template<typename FloatN>
+   void BVHTracer::ClosestHitPacket(const Ray* rays, TraceHit* hits, TraceStats* stats) const {
+      constexpr u32 N = FloatN::Width;
+
+      alignas(32) float originX[N], originY[N], originZ[N];
+      alignas(32) float invDirX[N], invDirY[N], invDirZ[N];
+      alignas(32) float tMax[N];
+
+      for (u32 i = 0; i < N; ++i) {
+         hits[i] = TraceHit{};
+
+         originX[i] = rays[i].origin.x;
+         originY[i] = rays[i].origin.y;
+         originZ[i] = rays[i].origin.z;
+         invDirX[i] = 1.f / rays[i].direction.x;
+         invDirY[i] = 1.f / rays[i].direction.y;
+         invDirZ[i] = 1.f / rays[i].direction.z;
+         tMax[i] = hits[i].tMax;
+      }
+
+      if (nodes.empty()) {
+         return;
+      }
+
+      const FloatN oX = FloatN::Load(originX);
+      const FloatN oY = FloatN::Load(originY);
+      const FloatN oZ = FloatN::Load(originZ);
+      const FloatN idX = FloatN::Load(invDirX);
+      const FloatN idY = FloatN::Load(invDirY);
+      const FloatN idZ = FloatN::Load(invDirZ);
+      const FloatN zero = FloatN::Set1(0);
+      FloatN tMaxN = FloatN::Load(tMax);
+
+      // returns mask of rays which intersect node
+      auto IntersectNodeN = [&](const BVHNode& node) {
+         FloatN t0x = (FloatN::Set1(node.aabbMin.x) - oX) * idX;
+         FloatN t1x = (FloatN::Set1(node.aabbMax.x) - oX) * idX;
+         FloatN t0y = (FloatN::Set1(node.aabbMin.y) - oY) * idY;
+         FloatN t1y = (FloatN::Set1(node.aabbMax.y) - oY) * idY;
+         FloatN t0z = (FloatN::Set1(node.aabbMin.z) - oZ) * idZ;
+         FloatN t1z = (FloatN::Set1(node.aabbMax.z) - oZ) * idZ;
+
+         FloatN tNear = Max(Max(Min(t0x, t1x), Min(t0y, t1y)), Max(Min(t0z, t1z), zero));
+         FloatN tFar = Min(Min(Max(t0x, t1x), Max(t0y, t1y)), Min(Max(t0z, t1z), tMaxN));
+
+         return MaskLessEqual(tNear, tFar);
+      };
+
+      vec3 packetDirection = vec3_Zero;
+      for (u32 i = 0; i < N; ++i) {
+         packetDirection += rays[i].direction;
+      }
+
+      TraceStack<u32> stack;
+      stack.Push(0);
+
+      while (!stack.Empty()) {
+         u32 iNode = stack.Pop();
+         const BVHNode& node = nodes[iNode];
+
+         u32 mask = IntersectNodeN(node);
+         if (mask == 0) {
+            continue;
+         }
+
+         // per ray, comparable with single ray traversal
+         if (stats) {
+            stats->nodesVisited += std::popcount(mask);
+         }
+
+         if (node.objIdx != UINT_MAX) {
+            const SRTObject& obj = objs[node.objIdx];
+
+            for (u32 i = 0; i < N; ++i) {
+               if (!(mask & (1u << i))) {
+                  continue;
+               }
+
+               if (stats) {
+                  stats->objsTested++;
+               }
+
+               if (IntersectObj(rays[i], obj, node.objIdx, hits[i])) {
+                  tMax[i] = hits[i].tMax;
+               }
+            }
+
+            tMaxN = FloatN::Load(tMax);
+            continue;
+         }
+
+         u32 iLeft = iNode + 1;
+         u32 iRight = node.secondChildOffset;
+
+         // children are tested when popped, here only order them along packet direction.
+         // Push far child first, so near child is visited first
+         const BVHNode& left = nodes[iLeft];
+         const BVHNode& right = nodes[iRight];
+         vec3 leftToRight = (right.aabbMin + right.aabbMax) - (left.aabbMin + left.aabbMax);
+         if (glm::dot(leftToRight, packetDirection) < 0) {
+            std::swap(iLeft, iRight);
+         }
+
+         stack.Push(iRight);
+         stack.Push(iLeft);
+      }
+   }
+
+   void BVHTracer::ClosestHit4(const Ray rays[4], TraceHit hits[4], TraceStats* stats) const {
+      ClosestHitPacket<Float4>(rays, hits, stats);
+   }
+
+   void BVHTracer::ClosestHit8(const Ray rays[8], TraceHit hits[8], TraceStats* stats) const {
+      ClosestHitPacket<Float8>(rays, hits, stats);
+   }
+
+   template<u32 Width>
+   WideBVHTracer<Width>::WideBVHTracer(const WideBVH<Width>& bvh, std::span<const SRTObject> objs)
+      : nodes(bvh.nodes), objs(objs) {
+   }
+
+   // one ray against all children of wide node. Returns mask of intersected lanes and their entry distances
+   template<u32 Width>
+   static u32 IntersectWideNode(const Ray& ray, const vec3& invDirection, float tMax, const WideBVHNode<Width>& node, float tNear[Width]) {
+      using FloatN = typename FloatForWidth<Width>::Type;
+
+      FloatN t0x = (FloatN::Load(node.minX) - FloatN::Set1(ray.origin.x)) * FloatN::Set1(invDirection.x);
+      FloatN t1x = (FloatN::Load(node.maxX) - FloatN::Set1(ray.origin.x)) * FloatN::Set1(invDirection.x);
+      FloatN t0y = (FloatN::Load(node.minY) - FloatN::Set1(ray.origin.y)) * FloatN::Set1(invDirection.y);
+      FloatN t1y = (FloatN::Load(node.maxY) - FloatN::Set1(ray.origin.y)) * FloatN::Set1(invDirection.y);
+      FloatN t0z = (FloatN::Load(node.minZ) - FloatN::Set1(ray.origin.z)) * FloatN::Set1(invDirection.z);
+      FloatN t1z = (FloatN::Load(node.maxZ) - FloatN::Set1(ray.origin.z)) * FloatN::Set1(invDirection.z);
+
+      FloatN tNearN = Max(Max(Min(t0x, t1x), Min(t0y, t1y)), Max(Min(t0z, t1z), FloatN::Set1(0)));
+      FloatN tFarN = Min(Min(Max(t0x, t1x), Max(t0y, t1y)), Min(Max(t0z, t1z), FloatN::Set1(tMax)));
+
+      tNearN.Store(tNear);
+      return MaskLessEqual(tNearN, tFarN);
+   }
+
+   template<u32 Width>
+   TraceHit WideBVHTracer<Width>::ClosestHit(const Ray& ray, float tMax, TraceStats* stats) const {
+      TraceHit hit;
+      hit.tMax = tMax;
+
+      if (nodes.empty()) {
+         return hit;
+      }
+
+      vec3 invDirection = 1.f / ray.direction;
+
+      struct StackEntry {
+         u32 nodeIdx;
+         float tNear;
+      };
+
+      TraceStack<StackEntry> stack;
+      stack.Push({ 0, 0 });
+
+      while (!stack.Empty()) {
+         auto [iNode, tNearNode] = stack.Pop();
+         if (tNearNode >= hit.tMax) {
+            continue;
+         }
+
+         if (stats) {
+            stats->nodesVisited++;
+         }
+
+         const auto& node = nodes[iNode];
+
+         float tNear[Width];
+         u32 mask = IntersectWideNode<Width>(ray, invDirection, hit.tMax, node, tNear);
+
+         // inner children sorted by distance, far first
+         StackEntry innerChildren[Width];
+         u32 nInnerChildren = 0;
+
+         for (u32 i = 0; i < Width; ++i) {
+            if (!(mask & (1u << i))) {
+               continue;
+            }
+
+            u32 child = node.children[i];
+            // empty lanes are last. Their inverted bounds dont fail slab test
+            if (child == UINT_MAX) {
+               break;
+            }
+
+            if (child & BVH_WIDE_LEAF) {
+               if (stats) {
+                  stats->objsTested++;
+               }
+
+               u32 objIdx = child & ~BVH_WIDE_LEAF;
+               BVHTracer::IntersectObj(ray, objs[objIdx], objIdx, hit);
+               continue;
+            }
+
+            StackEntry entry{ child, tNear[i] };
+
+            u32 j = nInnerChildren++;
+            while (j > 0 && innerChildren[j - 1].tNear < entry.tNear) {
+               innerChildren[j] = innerChildren[j - 1];
+               --j;
+            }
+            innerChildren[j] = entry;
+         }
+
+         for (u32 i = 0; i < nInnerChildren; ++i) {
+            stack.Push(innerChildren[i]);
+         }
+      }
+
+      return hit;
+   }
+
+   template<u32 Width>
+   bool WideBVHTracer<Width>::AnyHit(const Ray& ray, float tMax, TraceStats* stats) const {
+      if (nodes.empty()) {
+         return false;
+      }
+
+      vec3 invDirection = 1.f / ray.direction;
+
+      TraceHit hit;
+      hit.tMax = tMax;
+
+      TraceStack<u32> stack;
+      stack.Push(0);
+
+      while (!stack.Empty()) {
+         u32 iNode = stack.Pop();
+
+         if (stats) {
+            stats->nodesVisited++;
+         }
+
+         const auto& node = nodes[iNode];
+
+         float tNear[Width];
+         u32 mask = IntersectWideNode<Width>(ray, invDirection, tMax, node, tNear);
+
+         for (u32 i = 0; i < Width; ++i) {
+            if (!(mask & (1u << i))) {
+               continue;
+            }
+
+            u32 child = node.children[i];
+            // empty lanes are last. Their inverted bounds dont fail slab test
+            if (child == UINT_MAX) {
+               break;
+            }
+
+            if (child & BVH_WIDE_LEAF) {
+               if (stats) {
+                  stats->objsTested++;
+               }
+
+               u32 objIdx = child & ~BVH_WIDE_LEAF;
+               if (BVHTracer::IntersectObj(ray, objs[objIdx], objIdx, hit)) {
+                  return true;
+               }
+               continue;
+            }
+
+            stack.Push(child);
+         }
+      }
+
+      return false;
+   }
+
+   template class WideBVHTracer<4>;
+   template class WideBVHTracer<8>;
+
+   void BVHTraceBenchmark(u32 nObjs, u32 nRays) {
+      std::vector<SRTObject> objs(nObjs);
+      std::vector<AABB> aabbs(nObjs);
+
+      for (u32 i = 0; i < nObjs; ++i) {
+         auto& obj = objs[i];
+         obj.position = Random::Float3(vec3{ -100 }, vec3{ 100 });
+         obj.geomType = Random::Bool() ? 1 : 0;
+         obj.halfSize = obj.geomType == 1 ? Random::Float3(vec3{ 0.2f }, vec3{ 2 }) : vec3{ Random::Float(0.2f, 2) };
+         obj.rotation = vec4{ 1, 0, 0, 0 }; // identity in glm memory order
+
+         aabbs[i] = AABB::FromExtends(obj.position, obj.halfSize);
+      }
+
+      BVH bvh;
+      bvh.Build(aabbs, BVH::SplitMethod::BinnedSAH);
+      bvh.Flatten();
+
+      BVH4 bvh4;
+      bvh4.Collapse(bvh.linearNodes);
+      BVH8 bvh8;
+      bvh8.Collapse(bvh.linearNodes);
+
+      // pinhole camera in front of the scene, rays in scanline order
+      u32 width = (u32)sqrt((float)nRays);
+      u32 height = nRays / width;
+      nRays = width * height;
+
+      std::vector<Ray> rays(nRays);
+      for (u32 i = 0; i < nRays; ++i) {
+         vec2 uv = vec2{ (float)(i % width) / width, (float)(i / width) / height } * 2.f - 1.f;
+         rays[i] = Ray{ vec3{ 0, 0, -150 }, glm::normalize(vec3{ uv * 0.6f, 1 }) };
+      }
+
+      auto Bench = [&](const char* name, u32 nNodes, auto&& traceAll) {
+         TraceStats stats;
+
+         CpuTimer timer;
+         u32 nHits = traceAll(stats);
+         float elapsed = timer.Elapsed();
+
+         INFO("BVH trace benchmark {}: {} nodes, {:.1f} nodes visited per ray, {:.1f} objs tested per ray, {:.2f} Mrays/s, {} hits",
+            name, nNodes, (float)stats.nodesVisited / nRays, (float)stats.objsTested / nRays, nRays / elapsed / 1e6f, nHits);
+      };
+
+      BVHTracer tracer{ bvh.linearNodes, objs };
+      WideBVHTracer<4> tracer4{ bvh4, objs };
+      WideBVHTracer<8> tracer8{ bvh8, objs };
+
+      Bench("binary", (u32)bvh.linearNodes.size(), [&](TraceStats& stats) {
+         u32 nHits = 0;
+         for (auto& ray : rays) {
+            nHits += tracer.ClosestHit(ray, FLT_MAX, &stats).HasHit();
+         }
+         return nHits;
+      });
+
+      Bench("binary packet4", (u32)bvh.linearNodes.size(), [&](TraceStats& stats) {
+         u32 nHits = 0;
+         TraceHit hits[4];
+         for (u32 i = 0; i + 4 <= nRays; i += 4) {
+            tracer.ClosestHit4(&rays[i], hits, &stats);
+            for (auto& hit : hits) {
+               nHits += hit.HasHit();
+            }
+         }
+         return nHits;
+      });
+
+      Bench("BVH4", (u32)bvh4.nodes.size(), [&](TraceStats& stats) {
+         u32 nHits = 0;
+         for (auto& ray : rays) {
+            nHits += tracer4.ClosestHit(ray, FLT_MAX, &stats).HasHit();
+         }
+         return nHits;
+      });
+
+      Bench("BVH8", (u32)bvh8.nodes.size(), [&](TraceStats& stats) {
+         u32 nHits = 0;
+         for (auto& ray : rays) {
+            nHits += tracer8.ClosestHit(ray, FLT_MAX, &stats).HasHit();
+         }
+         return nHits;
+      });
+   }
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "core/Core.h"
+#include "BVH.h"
+#include "math/Shape.h"
+#include "shared/rt.hlsli"
+
+
+namespace pbe {
+
+   struct TraceHit {
+      vec3 position = vec3_Zero;
+      vec3 normal = vec3_Zero;
+      float tMax = FLT_MAX;
+      u32 objIdx = UINT_MAX;
+
+      bool HasHit() const { return objIdx != UINT_MAX; }
+   };
+
+   struct TraceStats {
+      u32 nodesVisited = 0; // per ray, packet node visit counts every active ray
+      u32 objsTested = 0;
+   };
+
+   // CPU traversal of depth first BVH.linearNodes, same data as rt.hlsl uses on gpu
+   class CORE_API BVHTracer {
+   public:
+      BVHTracer(std::span<const BVHNode> nodes, std::span<const SRTObject> objs);
+
+      TraceHit ClosestHit(const Ray& ray, float tMax = FLT_MAX, TraceStats* stats = nullptr) const;
+      // returns true on first hit closer than tMax. Useful for shadows and line of sight
+      bool AnyHit(const Ray& ray, float tMax = FLT_MAX, TraceStats* stats = nullptr) const;
+
+      // ray packets, node bounds are tested against all rays of the packet with one simd instruction.
+      // Rays in packet should be coherent (camera rays of small screen tile)
+      void ClosestHit4(const Ray rays[4], TraceHit hits[4], TraceStats* stats = nullptr) const;
+      void ClosestHit8(const Ray rays[8], TraceHit hits[8], TraceStats* stats = nullptr) const;
+
+      // intersect single object, updates hit if it is closer
+      static bool IntersectObj(const Ray& ray, const SRTObject& obj, u32 objIdx, TraceHit& hit);
+
+      std::span<const BVHNode> nodes;
+      std::span<const SRTObject> objs;
+
+   private:
+      template<typename FloatN>
+      void ClosestHitPacket(const Ray* rays, TraceHit* hits, TraceStats* stats) const;
+   };
+
+   // CPU traversal of BVH4/BVH8, each node tests all children with one simd instruction
+   template<u32 Width>
+   class WideBVHTracer {
+   public:
+      WideBVHTracer(const WideBVH<Width>& bvh, std::span<const SRTObject> objs);
+
+      TraceHit ClosestHit(const Ray& ray, float tMax = FLT_MAX, TraceStats* stats = nullptr) const;
+      bool AnyHit(const Ray& ray, float tMax = FLT_MAX, TraceStats* stats = nullptr) const;
+
+      std::span<const WideBVHNode<Width>> nodes;
+      std::span<const SRTObject> objs;
+   };
+
+   extern template class WideBVHTracer<4>;
+   extern template class WideBVHTracer<8>;
+
+   // trace camera rays over random scene with binary, BVH4 and BVH8 layouts and log nodes visited and rays per second
+   void BVHTraceBenchmark(u32 nObjs, u32 nRays);
+
+}
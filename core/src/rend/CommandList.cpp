@@ -81,6 +81,18 @@ namespace pbe {
       }
    }
 
+   void* CommandList::UpdateBufferMapped(Buffer& buffer, u32 bufferOffsetInBytes, size_t dataSizeInBytes) {
+      ASSERT(buffer.Valid() && dataSizeInBytes > 0);
+      ASSERT(bufferOffsetInBytes + dataSizeInBytes <= buffer.GetDesc().size);
+
+      auto allocation = m_UploadBuffer->Allocate(dataSizeInBytes, 4);
+
+      CopyBufferRegion(buffer, bufferOffsetInBytes,
+         *allocation.uploadBuffer, allocation.uploadBufferOffset, dataSizeInBytes);
+
+      return allocation.CPU;
+   }
+
    Ref<Buffer> CommandList::CreateBuffer(const Buffer::Desc& desc, const void* bufferData, u64 bufferSize) {
       ASSERT(bufferSize <= desc.size);
       if (desc.size == 0) {
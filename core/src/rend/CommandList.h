@@ -45,6 +45,9 @@ namespace pbe {
       void UpdateBuffer(Buffer& buffer, u32 bufferOffsetInBytes, const DataView<T>& data) {
          UpdateBuffer(buffer, bufferOffsetInBytes, data.data(), data.size() * sizeof(T));
       }
+      // returns upload memory that is copied to buffer when command list executes.
+      // Fill it before command list is submitted. Memory is write combined, don't read from it
+      void* UpdateBufferMapped(Buffer& buffer, u32 bufferOffsetInBytes, size_t dataSizeInBytes);
 
       Ref<Buffer> CreateBuffer(const Buffer::Desc& desc, const void* bufferData, u64 bufferSize);
       Ref<Buffer> CreateBuffer(const void* bufferData, u64 bufferSize); // todo: remove
@@ -458,14 +461,14 @@ namespace pbe {
             return;
          }
 
-         u64 psoHash = PipelineStateObject::PSODescHash(psoDescStream);
+         Hash128 psoHash = PipelineStateObject::PSODescHash(psoDescStream);
 
          auto nextPipelineState = sDevice->GetPSOFromCache(psoHash);
          if (nextPipelineState != nullptr && pipelineState.Raw() == nextPipelineState) {
             return;
          }
 
-         pipelineState = nextPipelineState;
+         pipelineState = std::move(nextPipelineState);
 
          if (!pipelineState) {
             pipelineState = Ref<PipelineStateObject>::Create(psoDescStream);
@@ -68,7 +68,7 @@ namespace pbe {
       CheckInflyCommandLists();
 
       if (!availableCommandListQueue.empty()) {
-         commandList = availableCommandListQueue.back();
+         commandList = std::move(availableCommandListQueue.back());
          availableCommandListQueue.pop_back();
       } else {
          commandList = Ref<CommandList>::Create(this);
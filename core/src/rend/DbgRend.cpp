@@ -1,16 +1,21 @@
 #include "pch.h"
 #include "DbgRend.h"
 
+#include "core/MemoryTracker.h"
 #include "scene/Entity.h"
 #include "scene/Component.h"
-#include "RendRes.h"
-#include "Shader.h"
-#include "CommandList.h"
 #include "math/Shape.h"
 
+#ifndef PBE_HEADLESS
+   #include "RendRes.h"
+   #include "Shader.h"
+   #include "CommandList.h"
+#endif
+
 
 namespace pbe {
    void DbgRend::DrawLine(const vec3& start, const vec3& end, const Color& color, bool zTest, EntityID entityID) {
+      MEMORY_TAG(DbgRend);
       u32 entityIDUint = (u32)entityID;
       if (zTest) {
          lines.emplace_back(start, entityIDUint, color);
@@ -23,6 +28,7 @@ namespace pbe {
 
    void DbgRend::DrawTriangle(const vec3& v0, const vec3& v1, const vec3& v2, const Color& color, bool zTest,
                               EntityID entityID) {
+      MEMORY_TAG(DbgRend);
       u32 entityIDUint = (u32)entityID;
       if (zTest) {
          triangles.emplace_back(v0, entityIDUint, color);
@@ -207,6 +213,7 @@ namespace pbe {
       trianglesNoZ.clear();
    }
 
+#ifndef PBE_HEADLESS
    void DbgRend::Render(CommandList& cmd, const RenderCamera& camera) {
       auto programDesc = ProgramDesc::VsGsPs("dbgRend.hlsl", "vs_main", "MainGS", "ps_main");
       programDesc.AddDefine("WITH_THICKNESS");
@@ -261,6 +268,7 @@ namespace pbe {
          }
       }
    }
+#endif
 
    DbgRend* GetDbgRend(const Scene& scene) {
       Scene& sceneRef = const_cast<Scene&>(scene);
@@ -39,7 +39,9 @@ namespace pbe {
 
       void Clear();
 
+#ifndef PBE_HEADLESS
       void Render(CommandList& cmd, const RenderCamera& camera);
+#endif
 
    private:
       std::vector<VertexPosUintColor> lines;
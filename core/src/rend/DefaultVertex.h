@@ -9,21 +9,27 @@ namespace pbe {
    struct VertexPos {
       vec3 position;
 
+#ifndef PBE_HEADLESS
       static inline std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDesc;
+#endif
    };
 
    struct VertexPosNormal {
       vec3 position;
       vec3 normal;
 
+#ifndef PBE_HEADLESS
       static inline std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDesc;
+#endif
    };
 
    struct VertexPosColor {
       vec3 position;
       vec4 color;
 
+#ifndef PBE_HEADLESS
       static inline std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDesc;
+#endif
    };
 
    struct CORE_API VertexPosUintColor {
@@ -31,6 +37,8 @@ namespace pbe {
       u32 uintValue;
       vec4 color;
 
+#ifndef PBE_HEADLESS
       static inline std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDesc;
+#endif
    };
 }
@@ -264,15 +264,15 @@ namespace pbe {
       ReleaseStaleDescriptors();
    }
 
-   Ref<PipelineStateObject> Device::GetPSOFromCache(u64 psoHash) const {
+   Ref<PipelineStateObject> Device::GetPSOFromCache(const Hash128& psoHash) const {
       auto iter = psoCache.find(psoHash);
       return iter == psoCache.end() ? Ref<PipelineStateObject>{} : iter->second;
    }
 
-   void Device::AddPSOToCache(u64 psoHash, Ref<PipelineStateObject> pso) {
+   void Device::AddPSOToCache(const Hash128& psoHash, Ref<PipelineStateObject> pso) {
       if (pso) {
          ASSERT(!psoCache.contains(psoHash));
-         psoCache[psoHash] = pso;
+         psoCache[psoHash] = std::move(pso);
       }
    }
 
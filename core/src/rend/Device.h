@@ -14,6 +14,7 @@
 #include "core/Core.h"
 #include "core/Ref.h"
 #include "math/Types.h"
+#include "utils/Hash.h"
 
 namespace pbe {
    class CommandList;
@@ -58,8 +59,8 @@ namespace pbe {
 
       void Present();
 
-      Ref<PipelineStateObject> GetPSOFromCache(u64 psoHash) const;
-      void AddPSOToCache(u64 psoHash, Ref<PipelineStateObject> pso);
+      Ref<PipelineStateObject> GetPSOFromCache(const Hash128& psoHash) const;
+      void AddPSOToCache(const Hash128& psoHash, Ref<PipelineStateObject> pso);
 
       // todo: move to private
       ComPtr<ID3D12Device5> g_Device;
@@ -91,7 +92,7 @@ namespace pbe {
    private:
       std::unique_ptr<DescriptorAllocator> m_DescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
       std::unique_ptr<GlobalDescriptorHeap> pGlobalDescriptorHeap[2]; // 0 - CBV_SRV_UAV, 1 - SAMPLER
-      std::unordered_map<u64, Ref<PipelineStateObject>> psoCache;
+      std::unordered_map<Hash128, Ref<PipelineStateObject>> psoCache;
 
       Features features;
 
@@ -33,84 +33,84 @@ PipelineStateObject::PipelineStateObject(const CD3DX12_PIPELINE_STATE_STREAM2& s
    ThrowIfFailed(d3d12Device->CreatePipelineState(&desc, IID_PPV_ARGS(&m_d3d12PipelineState)));
 }
 
-u64 PipelineStateObject::PSODescHash(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc) {
-   u64 hash = 0;
-   HashCombine(hash, desc.pRootSignature);
-   HashCombine(hash, desc.CS.pShaderBytecode);
-   HashCombine(hash, desc.NodeMask);
-   HashCombine(hash, desc.Flags);
-
-   return hash;
+Hash128 PipelineStateObject::PSODescHash(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc) {
+   Hasher hasher;
+   hasher.Add(desc.pRootSignature);
+   hasher.Add(desc.CS.pShaderBytecode);
+   hasher.Add(desc.NodeMask);
+   hasher.Add(desc.Flags);
+
+   return hasher.Get128();
 }
 
-u64 PipelineStateObject::PSODescHash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) {
-   u64 hash = 0;
-   HashCombine(hash, desc.pRootSignature);
-   HashCombine(hash, desc.VS.pShaderBytecode);
-   HashCombine(hash, desc.HS.pShaderBytecode);
-   HashCombine(hash, desc.DS.pShaderBytecode);
-   HashCombine(hash, desc.GS.pShaderBytecode);
-   HashCombine(hash, desc.PS.pShaderBytecode);
-
-   HashCombine(hash, desc.BlendState.AlphaToCoverageEnable);
-   HashCombine(hash, desc.BlendState.IndependentBlendEnable);
-   HashCombineMemory(hash, desc.BlendState.RenderTarget[0]);
-
-   HashCombineMemory(hash, desc.RasterizerState);
-   HashCombineMemory(hash, desc.DepthStencilState);
-   HashCombineMemory(hash, desc.InputLayout.pInputElementDescs, sizeof(D3D12_INPUT_ELEMENT_DESC) * desc.InputLayout.NumElements);
-   HashCombine(hash, desc.PrimitiveTopologyType);
-   HashCombineMemory(hash, desc.RTVFormats, sizeof(DXGI_FORMAT) * desc.NumRenderTargets);
-   HashCombine(hash, desc.DSVFormat);
-   HashCombine(hash, desc.Flags);
-
-   return hash;
+Hash128 PipelineStateObject::PSODescHash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) {
+   Hasher hasher;
+   hasher.Add(desc.pRootSignature);
+   hasher.Add(desc.VS.pShaderBytecode);
+   hasher.Add(desc.HS.pShaderBytecode);
+   hasher.Add(desc.DS.pShaderBytecode);
+   hasher.Add(desc.GS.pShaderBytecode);
+   hasher.Add(desc.PS.pShaderBytecode);
+
+   hasher.Add(desc.BlendState.AlphaToCoverageEnable);
+   hasher.Add(desc.BlendState.IndependentBlendEnable);
+   hasher.Add(desc.BlendState.RenderTarget[0]);
+
+   hasher.Add(desc.RasterizerState);
+   hasher.Add(desc.DepthStencilState);
+   hasher.AddMemory(desc.InputLayout.pInputElementDescs, sizeof(D3D12_INPUT_ELEMENT_DESC) * desc.InputLayout.NumElements);
+   hasher.Add(desc.PrimitiveTopologyType);
+   hasher.AddMemory(desc.RTVFormats, sizeof(DXGI_FORMAT) * desc.NumRenderTargets);
+   hasher.Add(desc.DSVFormat);
+   hasher.Add(desc.Flags);
+
+   return hasher.Get128();
 }
 
-u64 PipelineStateObject::PSODescHash(const CD3DX12_PIPELINE_STATE_STREAM2& desc) {
+Hash128 PipelineStateObject::PSODescHash(const CD3DX12_PIPELINE_STATE_STREAM2& desc) {
    bool isCompute = desc.CS.Get().BytecodeLength > 0;
    bool isGraphics = desc.VS.Get().BytecodeLength > 0;
    bool isGraphicsMesh = desc.MS.Get().BytecodeLength > 0;
    ASSERT(int(isCompute) + int(isGraphics) + int(isGraphicsMesh) == 1);
 
-   u64 hash = 0;
+   Hasher hasher;
 
    if (isCompute) {
-      HashCombine(hash, desc.pRootSignature.Get());
+      hasher.Add(desc.pRootSignature.Get());
 
-      HashCombine(hash, desc.CS.Get().pShaderBytecode);
+      hasher.Add(desc.CS.Get().pShaderBytecode);
 
-      HashCombine(hash, desc.NodeMask.Get());
-      HashCombine(hash, desc.Flags.Get());
+      hasher.Add(desc.NodeMask.Get());
+      hasher.Add(desc.Flags.Get());
    } else {
-      HashCombine(hash, desc.pRootSignature.Get());
+      hasher.Add(desc.pRootSignature.Get());
 
       if (isGraphics) {
-         HashCombine(hash, desc.VS.Get().pShaderBytecode);
-         HashCombine(hash, desc.HS.Get().pShaderBytecode);
-         HashCombine(hash, desc.DS.Get().pShaderBytecode);
-         HashCombine(hash, desc.GS.Get().pShaderBytecode);
+         hasher.Add(desc.VS.Get().pShaderBytecode);
+         hasher.Add(desc.HS.Get().pShaderBytecode);
+         hasher.Add(desc.DS.Get().pShaderBytecode);
+         hasher.Add(desc.GS.Get().pShaderBytecode);
       } else {
-         HashCombine(hash, desc.AS.Get().pShaderBytecode);
-         HashCombine(hash, desc.MS.Get().pShaderBytecode);
+         hasher.Add(desc.AS.Get().pShaderBytecode);
+         hasher.Add(desc.MS.Get().pShaderBytecode);
       }
 
-      HashCombine(hash, desc.PS.Get().pShaderBytecode);
+      hasher.Add(desc.PS.Get().pShaderBytecode);
 
-      HashCombine(hash, desc.BlendState.Get().AlphaToCoverageEnable);
-      HashCombine(hash, desc.BlendState.Get().IndependentBlendEnable);
-      HashCombineMemory(hash, desc.BlendState.Get().RenderTarget[0]);
+      hasher.Add(desc.BlendState.Get().AlphaToCoverageEnable);
+      hasher.Add(desc.BlendState.Get().IndependentBlendEnable);
+      hasher.Add(desc.BlendState.Get().RenderTarget[0]);
 
-      HashCombineMemory(hash, desc.RasterizerState.Get());
-      HashCombineMemory(hash, desc.DepthStencilState.Get());
-      HashCombineMemory(hash, desc.InputLayout.Get().pInputElementDescs,
+      hasher.Add(desc.RasterizerState.Get());
+      hasher.Add(desc.DepthStencilState.Get());
+      hasher.AddMemory(desc.InputLayout.Get().pInputElementDescs,
          sizeof(D3D12_INPUT_ELEMENT_DESC) * desc.InputLayout.Get().NumElements);
-      HashCombine(hash, desc.PrimitiveTopologyType.Get());
-      HashCombineMemory(hash, desc.RTVFormats.Get().RTFormats,
+      hasher.Add(desc.PrimitiveTopologyType.Get());
+      hasher.AddMemory(desc.RTVFormats.Get().RTFormats,
          sizeof(DXGI_FORMAT) * desc.RTVFormats.Get().NumRenderTargets);
-      HashCombine(hash, desc.DSVFormat.Get());
-      HashCombine(hash, desc.Flags.Get());
+      hasher.Add(desc.DSVFormat.Get());
+      hasher.Add(desc.Flags.Get());
    }
 
-   return hash;
+   return hasher.Get128();
 }
@@ -3,6 +3,7 @@
 #include "Common.h"
 #include "d3dx12.h"
 #include "core/Ref.h"
+#include "utils/Hash.h"
 
 namespace pbe {
    class PipelineStateObject : public RefCounted {
@@ -21,10 +22,10 @@ namespace pbe {
       bool IsGraphics() const { return !IsCompute(); };
 
       // todo: remove
-      static u64 PSODescHash(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
-      static u64 PSODescHash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+      static Hash128 PSODescHash(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
+      static Hash128 PSODescHash(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
 
-      static u64 PSODescHash(const CD3DX12_PIPELINE_STATE_STREAM2& desc);
+      static Hash128 PSODescHash(const CD3DX12_PIPELINE_STATE_STREAM2& desc);
 
    private:
       ComPtr<ID3D12PipelineState> m_d3d12PipelineState;
@@ -9,9 +9,11 @@
 #include "AccelerationStructure.h"
 #include "Buffer.h"
 #include "BVH.h"
+#include "BVHTracer.h"
 #include "CommandList.h"
 #include "DbgRend.h"
 #include "NRDDenoiser.h"
+#include "RefPathTracer.h"
 #include "RenderContext.h"
 #include "Renderer.h" // todo:
 #include "Shader.h"
@@ -42,7 +44,11 @@ namespace pbe {
    CVarValue<bool> cvRTSpecular{ "render/rt/specular", true }; // todo
    CVarValue<bool> cvBvhAABBRender{ "render/rt/bvh aabb render", false };
    CVarValue<u32> cvBvhAABBRenderLevel{ "render/rt/bvh aabb show level", UINT_MAX };
-   CVarValue<u32> cvBvhSplitMethod{ "render/rt/bvh split method", 2 };
+   CVarValue<u32> cvBvhSplitMethod{ "render/rt/bvh split method", 3 };
+   CVarTrigger cvBvhBuildBenchmark{ "render/rt/bvh build benchmark" };
+   CVarTrigger cvBvhTraceBenchmark{ "render/rt/bvh trace benchmark" };
+   CVarTrigger cvRefPathTracerSave{ "render/rt/ref path tracer save" };
+   CVarSlider<float> cvBvhRebuildThreshold{ "render/rt/bvh rebuild sah threshold", 1.3f, 1.f, 4.f };
    CVarValue<bool> cvUsePSR{ "render/rt/use psr", false }; // todo: on my laptop it takes 50% more time
 
    CVarValue<bool> cvDenoise{ "render/denoise/enable", true };
@@ -61,93 +67,104 @@ namespace pbe {
       NRDTerm();
    }
 
-   void RTRenderer::RenderScene(CommandList& cmd, const Scene& scene, const RenderCamera& camera, RenderContext& context) {
-      COMMAND_LIST_SCOPE(cmd, "RT Scene");
-      PROFILE_GPU("RT Scene");
+   bool RTRenderer::UpdateBVH(std::span<const u32> objIds, std::span<AABB> aabbs) {
+      PROFILE_CPU("BVH update");
 
-      PIX_EVENT_SYSTEM(Render, "RT Render Scene");
+      if (!bvh) {
+         bvh = std::make_unique<BVH>();
+      }
 
-      std::vector<SRTObject> objs;
+      u32 nObj = (u32)objIds.size();
 
-      std::vector<AABB> aabbs;
+      bool rebuild = bvhSplitMethod != cvBvhSplitMethod || bvhObjIds.size() != nObj;
+      for (u32 i = 0; !rebuild && i < nObj; ++i) {
+         rebuild = bvhObjIds[i] != objIds[i];
+      }
 
-      for (auto [e, trans, material, geom]
-         : scene.View<SceneTransformComponent, MaterialComponent, GeometryComponent>().each()) {
-         auto rotation = trans.Rotation();
-         auto position = trans.Position();
-         auto scale = trans.Scale();
+      bool changed = rebuild;
 
-         SRTObject obj;
-         obj.position = position;
-         obj.id = (u32)e;
+      if (!rebuild) {
+         bvhChangedObjs.clear();
+         for (u32 i = 0; i < nObj; ++i) {
+            if (aabbs[i].min != bvhAabbs[i].min || aabbs[i].max != bvhAabbs[i].max) {
+               bvhChangedObjs.push_back(i);
+            }
+         }
 
-         obj.rotation = glm::make_vec4(glm::value_ptr(rotation));
+         if (!bvhChangedObjs.empty()) {
+            bvh->Refit(aabbs, bvhChangedObjs);
+            changed = true;
 
-         obj.geomType = (int)geom.type;
-         obj.halfSize = geom.sizeData / 2.f * scale;
+            rebuild = bvh->SAHCost() > bvhBuildSAHCost * cvBvhRebuildThreshold;
+         }
+      }
 
-         obj.baseColor = material.baseColor;
-         obj.metallic = material.metallic;
-         obj.roughness = material.roughness;
-         obj.emissivePower = material.emissivePower;
+      if (rebuild) {
+         PROFILE_CPU("BVH build");
 
-         // todo: sphere may be optimized
-         // todo: not fastest way
+         bvhSplitMethod = cvBvhSplitMethod;
+         bvh->Build(aabbs, (BVH::SplitMethod)bvhSplitMethod);
+         bvh->Flatten();
+         bvhBuildSAHCost = bvh->SAHCost();
 
-         auto extends = scale * 0.5f;
-         auto aabb = AABB::Empty();
+         bvhObjIds.assign(objIds.begin(), objIds.end());
+      }
 
-         if (geom.type == GeomType::Box) {
-            aabb.AddPoint(rotation * extends);
-            aabb.AddPoint(rotation * vec3{ -extends.x, extends.y, extends.z });
-            aabb.AddPoint(rotation * vec3{ extends.x, -extends.y, extends.z });
-            aabb.AddPoint(rotation * vec3{ extends.x, extends.y, -extends.z });
+      if (changed) {
+         bvhAabbs.assign(aabbs.begin(), aabbs.end());
+      }
 
-            vec3 absMax = glm::max(abs(aabb.min), abs(aabb.max));
-            aabb.min = -absMax;
-            aabb.max = absMax;
+      return changed;
+   }
 
-            aabb.Translate(position);
-         } else {
-            auto sphereExtends = vec3{ extends.x };
-            aabb = AABB::FromExtends(trans.Position(), sphereExtends);
-         }
+   void RTRenderer::RenderScene(CommandList& cmd, const Scene& scene, const RenderCamera& camera, RenderContext& context) {
+      COMMAND_LIST_SCOPE(cmd, "RT Scene");
+      PROFILE_GPU("RT Scene");
+
+      PIX_EVENT_SYSTEM(Render, "RT Render Scene");
 
-         aabbs.emplace_back(aabb);
+      FrameVector<SRTObject> objs;
+      FrameVector<AABB> aabbs;
+      GatherRTObjects(scene, objs, aabbs);
 
-         objs.emplace_back(obj);
+      if (cvBvhBuildBenchmark) {
+         BVHBuildBenchmark(100'000);
+      }
+      if (cvBvhTraceBenchmark) {
+         BVHTraceBenchmark(100'000, 512 * 512);
       }
 
       u32 nBvhNodes = 0;
       if (cvCustomTrace) {
-         // todo: dont create every frame
-         BVH bvh;
-         bvh.Build(aabbs, (BVH::SplitMethod)(u32)cvBvhSplitMethod);
+         FrameVector<u32> objIds(objs.size());
+         for (u32 i = 0; i < (u32)objs.size(); ++i) {
+            objIds[i] = objs[i].id;
+         }
+
+         bool bvhChanged = UpdateBVH(objIds, aabbs);
 
          if (cvBvhAABBRender) {
             auto& dbgRender = *GetDbgRend(scene);
-            // for (auto& aabb : aabbs) {
-            //    dbgRender.DrawAABB(aabb);
-            // }
-            bvh.Render(dbgRender, cvBvhAABBRenderLevel);
+            bvh->Render(dbgRender, cvBvhAABBRenderLevel);
          }
 
-         bvh.Flatten();
-
-
          // todo: make it dynamic
-         auto& bvhNodes = bvh.linearNodes;
+         auto& bvhNodes = bvh->linearNodes;
          nBvhNodes = (u32)bvhNodes.size();
          if (!bvhNodesBuffer || bvhNodesBuffer->NumElements() < nBvhNodes) {
             auto bufferDesc = Buffer::Desc::Structured("BVHNodes", nBvhNodes, sizeof(BVHNode));
             bvhNodesBuffer = Buffer::Create(bufferDesc);
+            bvhChanged = true;
+         }
+         if (bvhChanged && nBvhNodes > 0) {
+            cmd.UpdateBuffer(*bvhNodesBuffer, 0, DataView{ bvhNodes });
          }
-         cmd.UpdateBuffer(*bvhNodesBuffer, 0, DataView{ bvhNodes });
       } else {
          COMMAND_LIST_SCOPE(cmd, "Build AS");
          PROFILE_GPU("Build AS");
 
-         std::vector<AccelerationStructure::AABB> blasAabbs;
+         FrameVector<AccelerationStructure::AABB> blasAabbs;
+         blasAabbs.reserve(aabbs.size());
          for (auto&& aabb : aabbs) {
             AccelerationStructure::AABB blasAabb {
                .minX = aabb.min.x,
@@ -165,7 +182,7 @@ namespace pbe {
          blas->Build(cmd);
 
          Array<AccelerationStructure::Instance> instances;
-         instances.emplace_back(Transform_Identity, blas);
+         instances.emplace_back(Transform_Identity, std::move(blas));
 
          if (false) {
             vec3 vertexes[3] = {
@@ -187,7 +204,7 @@ namespace pbe {
             blasTri->AddTriangles(vertexesBuffer, indexesBuffer);
             blasTri->Build(cmd);
 
-            instances.emplace_back(Transform_Identity, blasTri);
+            instances.emplace_back(Transform_Identity, std::move(blasTri));
          }
 
          if (context.grassCounters) {
@@ -195,7 +212,7 @@ namespace pbe {
             grassBlas->AddTriangles(context.grassVertexes, context.grassIndexes);
             grassBlas->Build(cmd);
 
-            instances.emplace_back(Transform_Identity, grassBlas);
+            instances.emplace_back(Transform_Identity, std::move(grassBlas));
          }
 
          // AccelerationStructure::Instance instance{ Transform_Identity, blas };
@@ -219,7 +236,7 @@ namespace pbe {
 
       u32 nImportanceVolumes = 0;
       {
-         std::vector<SRTImportanceVolume> importanceVolumes;
+         FrameVector<SRTImportanceVolume> importanceVolumes;
 
          for (auto [e, trans, volume]
             : scene.View<SceneTransformComponent, RTImportanceVolumeComponent>().each()) {
@@ -262,6 +279,21 @@ namespace pbe {
          accumulatedFrames = 0;
       }
 
+      if (cvRefPathTracerSave) {
+         // same settings as rtCS for side by side comparison with gpu output
+         RefPathTracer refTracer;
+         refTracer.SetScene(scene);
+
+         RefPathTracer::Desc desc;
+         desc.size = outTexSize;
+         desc.rayDepth = cvRayDepth;
+         desc.nSamples = cvNRays;
+         refTracer.Render(desc, camera.position, glm::inverse(camera.GetViewProjection()));
+
+         refTracer.SavePFM("refPathTracer.pfm");
+         refTracer.SavePPM("refPathTracer.ppm");
+      }
+
       SRTConstants rtCB;
       rtCB.rtSize = outTexSize;
       rtCB.rayDepth = cvRayDepth;
@@ -1,5 +1,6 @@
 #pragma once
 #include "core/Ref.h"
+#include "math/Shape.h"
 
 
 namespace pbe {
@@ -11,6 +12,7 @@ namespace pbe {
    class CommandList;
    class GpuProgram;
    struct RenderContext;
+   struct BVH;
 
    class CORE_API RTRenderer {
    public:
@@ -21,6 +23,18 @@ namespace pbe {
       Ref<Buffer> rtObjectsBuffer;
       Ref<Buffer> bvhNodesBuffer;
       Ref<Buffer> importanceVolumesBuffer;
+
+   private:
+      // persistent bvh for custom trace. Refitted while objects only move, rebuilt when quality degrades
+      Own<BVH> bvh;
+      std::vector<u32> bvhObjIds;
+      std::vector<AABB> bvhAabbs;
+      std::vector<u32> bvhChangedObjs;
+      u32 bvhSplitMethod = UINT_MAX;
+      float bvhBuildSAHCost = 0;
+
+      // returns true if bvh nodes were changed
+      bool UpdateBVH(std::span<const u32> objIds, std::span<AABB> aabbs);
    };
 
 }
@@ -0,0 +1,375 @@
+#include "pch.h"
+#include "RefPathTracer.h"
+
+#include <atomic>
+#include <bit>
+#include <fstream>
+
+#include "BVH.h"
+#include "BVHTracer.h"
+#include "core/Assert.h"
+#include "core/JobSystem.h"
+#include "core/Profiler.h"
+#include "scene/Component.h"
+#include "scene/Entity.h"
+#include "scene/Scene.h"
+
+
+namespace pbe {
+
+   // same as gDirectLightTanAngularRadius in rt.hlsl
+   constexpr float DIRECT_LIGHT_TAN_ANGULAR_RADIUS = 0.05f;
+
+   // random.hlsli
+   static u32 PcgHash(u32 input) {
+      u32 state = input * 747796405u + 2891336453u;
+      u32 word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+      return (word >> 22u) ^ word;
+   }
+
+   static float RandomFloat(u32& seed) {
+      seed = PcgHash(seed);
+      // _UintToFloat01
+      return 2.f - std::bit_cast<float>((seed >> 9) | 0x3F800000u);
+   }
+
+   static vec2 RandomFloat2(u32& seed) {
+      float x = RandomFloat(seed);
+      return { x, RandomFloat(seed) };
+   }
+
+   static u32 RandomInitialize(uint2 id, u32 frameIdx) {
+      return id.x * 214234 + id.y * 521334 + PcgHash(frameIdx * 171915 + 968123);
+   }
+
+   static vec3 RandomPointOnUnitSphere(u32& seed) {
+      float theta = PI2 * RandomFloat(seed);
+      float phi = std::acos(1.f - 2.f * RandomFloat(seed));
+      return { std::sin(phi) * std::cos(theta), std::sin(phi) * std::sin(theta), std::cos(phi) };
+   }
+
+   static vec3 RandomPointOnUnitHemisphere(const vec3& normal, u32& seed) {
+      vec3 p = RandomPointOnUnitSphere(seed);
+      return p * glm::sign(glm::dot(p, normal));
+   }
+
+   // STL::Geometry::GetBasis, returns tangent and bitangent
+   static void GetBasis(const vec3& n, vec3& t, vec3& b) {
+      float sz = n.z >= 0 ? 1.f : -1.f;
+      float a = 1.f / (sz + n.z);
+      float ya = n.y * a;
+      float bb = n.x * ya;
+      float c = n.x * sz;
+
+      t = { c * n.x * a - 1.f, sz * bb, c };
+      b = { bb, n.y * ya - sz, n.y };
+   }
+
+   // LightDirection in rt.hlsl
+   static vec3 LightDirection(const vec3& toLight, float tanAngularRadius, u32& seed) {
+      vec2 rnd = RandomFloat2(seed);
+
+      // STL::ImportanceSampling::Cosine::GetRay
+      float phi = rnd.x * PI2;
+      float cosTheta = glm::clamp(std::sqrt(rnd.y), 0.f, 1.f);
+      float sinTheta = glm::clamp(std::sqrt(1.f - cosTheta * cosTheta), 0.f, 1.f);
+      rnd = vec2{ sinTheta * std::cos(phi), sinTheta * std::sin(phi) } * tanAngularRadius;
+
+      vec3 t, b;
+      GetBasis(toLight, t, b);
+      return glm::normalize(t * rnd.x + b * rnd.y + toLight);
+   }
+
+   template<typename ObjsVector, typename AabbsVector>
+   static void GatherRTObjectsImpl(const Scene& scene, ObjsVector& objs, AabbsVector& aabbs) {
+      auto view = scene.View<SceneTransformComponent, MaterialComponent, GeometryComponent>();
+
+      objs.clear();
+      aabbs.clear();
+      objs.reserve(view.size_hint());
+      aabbs.reserve(view.size_hint());
+
+      for (auto [e, trans, material, geom] : view.each()) {
+         auto rotation = trans.Rotation();
+         auto position = trans.Position();
+         auto scale = trans.Scale();
+
+         SRTObject obj;
+         obj.position = position;
+         obj.id = (u32)e;
+
+         obj.rotation = glm::make_vec4(glm::value_ptr(rotation));
+
+         obj.geomType = (int)geom.type;
+         obj.halfSize = geom.sizeData / 2.f * scale;
+
+         obj.baseColor = material.baseColor;
+         obj.metallic = material.metallic;
+         obj.roughness = material.roughness;
+         obj.emissivePower = material.emissivePower;
+
+         // todo: sphere may be optimized
+         // todo: not fastest way
+         auto extends = scale * 0.5f;
+         auto aabb = AABB::Empty();
+
+         if (geom.type == GeomType::Box) {
+            aabb.AddPoint(rotation * extends);
+            aabb.AddPoint(rotation * vec3{ -extends.x, extends.y, extends.z });
+            aabb.AddPoint(rotation * vec3{ extends.x, -extends.y, extends.z });
+            aabb.AddPoint(rotation * vec3{ extends.x, extends.y, -extends.z });
+
+            vec3 absMax = glm::max(abs(aabb.min), abs(aabb.max));
+            aabb.min = -absMax;
+            aabb.max = absMax;
+
+            aabb.Translate(position);
+         } else {
+            auto sphereExtends = vec3{ extends.x };
+            aabb = AABB::FromExtends(trans.Position(), sphereExtends);
+         }
+
+         aabbs.emplace_back(aabb);
+
+         objs.emplace_back(obj);
+      }
+   }
+
+   void GatherRTObjects(const Scene& scene, std::vector<SRTObject>& objs, std::vector<AABB>& aabbs) {
+      GatherRTObjectsImpl(scene, objs, aabbs);
+   }
+
+   void GatherRTObjects(const Scene& scene, FrameVector<SRTObject>& objs, FrameVector<AABB>& aabbs) {
+      GatherRTObjectsImpl(scene, objs, aabbs);
+   }
+
+   RefPathTracer::RefPathTracer() = default;
+   RefPathTracer::~RefPathTracer() = default;
+
+   void RefPathTracer::SetScene(const Scene& scene) {
+      PROFILE_CPU("Ref path tracer set scene");
+
+      GatherRTObjects(scene, objs, aabbs);
+
+      if (!bvh) {
+         bvh = std::make_unique<BVH>();
+      }
+      bvh->Build(aabbs, BVH::SplitMethod::BinnedSAH);
+      bvh->Flatten();
+
+      // same as scene constant buffer in Renderer
+      directLightColor = vec3_Zero;
+      directLightDirection = vec3{ 1, 0, 0 };
+      if (Entity directEntity = Entity::GetAnyWithComponent<DirectLightComponent>(scene)) {
+         auto& directLight = directEntity.Get<DirectLightComponent>();
+         directLightColor = directLight.color * directLight.intensity;
+         directLightDirection = directEntity.GetTransform().Forward();
+      }
+
+      skyIntensity = 0;
+      if (Entity skyEntity = Entity::GetAnyWithComponent<SkyComponent>(scene)) {
+         skyIntensity = skyEntity.Get<SkyComponent>().intensity;
+      }
+   }
+
+   RefPathTracer::Stats RefPathTracer::Render(const Desc& desc, const vec3& cameraPos, const mat4& invViewProjection) {
+      PROFILE_CPU("Ref path tracer render");
+
+      size = desc.size;
+      image.assign((size_t)size.x * size.y, vec3_Zero);
+
+      u32 tileSize = std::max(desc.tileSize, 1u);
+      uint2 nTiles = (size + tileSize - 1u) / tileSize;
+      u32 nTilesTotal = nTiles.x * nTiles.y;
+
+      std::atomic<u64> nRaysTotal = 0;
+
+      CpuTimer timer;
+
+      // one tile per job, so slow tiles don't stall other threads
+      JobSystem::Get().ParallelFor("Ref path tracer tiles", nTilesTotal, 1, [&](u32 begin, u32 end) {
+         u64 nRays = 0;
+
+         for (u32 tile = begin; tile < end; ++tile) {
+            uint2 tileMin = uint2{ tile % nTiles.x, tile / nTiles.x } * tileSize;
+            uint2 tileMax = glm::min(tileMin + tileSize, size);
+
+            for (u32 y = tileMin.y; y < tileMax.y; ++y) {
+               for (u32 x = tileMin.x; x < tileMax.x; ++x) {
+                  u32 seed = RandomInitialize({ x, y }, desc.frameIdx);
+
+                  // CreateCameraRay in rt.hlsl
+                  vec2 uv = (vec2{ x, y } + 0.5f) / vec2{ size };
+                  vec4 ndc{ uv.x * 2.f - 1.f, 1.f - uv.y * 2.f, 1, 1 };
+                  vec4 posW = invViewProjection * ndc;
+                  Ray ray{ cameraPos, glm::normalize(vec3{ posW } / posW.w - cameraPos) };
+
+                  vec3 color = vec3_Zero;
+                  for (u32 i = 0; i < desc.nSamples; ++i) {
+                     color += RayColor(ray, desc.rayDepth, seed, nRays);
+                  }
+
+                  image[y * size.x + x] = color / (float)std::max(desc.nSamples, 1u);
+               }
+            }
+         }
+
+         nRaysTotal += nRays;
+      });
+
+      Stats stats;
+      stats.nRays = nRaysTotal;
+      stats.elapsedMs = timer.ElapsedMs();
+
+      INFO("Ref path tracer: {}x{} {} spp, {} threads, {:.1f} ms, {:.2f} Mrays/s",
+         size.x, size.y, desc.nSamples, JobSystem::Get().NumThreads(), stats.elapsedMs, stats.MRaysPerSec());
+
+      return stats;
+   }
+
+   vec3 RefPathTracer::RayColor(Ray ray, u32 rayDepth, u32& seed, u64& nRays) const {
+      BVHTracer tracer{ bvh->linearNodes, objs };
+
+      vec3 color = vec3_Zero;
+      vec3 energy = vec3_One;
+
+      for (u32 depth = 0; depth < rayDepth; ++depth) {
+         TraceHit hit = tracer.ClosestHit(ray);
+         ++nRays;
+
+         if (hit.HasHit()) {
+            const SRTObject& obj = objs[hit.objIdx];
+
+            ray.origin = hit.position;
+
+            vec3 N = hit.normal;
+
+            color += obj.baseColor * obj.emissivePower * energy; // todo: device by PI_2?
+
+            // todo: specular branch is disabled in rt.hlsl too
+            vec3 albedo = obj.baseColor * (1 - obj.metallic);
+
+            // shadow test ray
+            vec3 L = LightDirection(-directLightDirection, DIRECT_LIGHT_TAN_ANGULAR_RADIUS, seed);
+            float NDotL = glm::dot(N, L);
+
+            if (NDotL > 0) {
+               ++nRays;
+               if (!tracer.AnyHit(Ray{ ray.origin, L })) {
+                  color += NDotL * albedo * directLightColor * energy;
+               }
+            }
+
+            ray.direction = glm::normalize(RandomPointOnUnitHemisphere(hit.normal, seed));
+
+            float NDotRayDir = std::max(glm::dot(N, ray.direction), 0.f);
+            energy *= albedo * NDotRayDir;
+         } else {
+            color += SkyColor(ray.direction) * energy;
+            break;
+         }
+      }
+
+      return color;
+   }
+
+   // GetSkyColor from sky.hlsli
+   vec3 RefPathTracer::SkyColor(vec3 rd) const {
+      vec3 sunDir = -directLightDirection;
+
+      float yd = std::min(rd.y, 0.f);
+      rd.y = std::max(rd.y, 0.f);
+
+      vec3 col = vec3_Zero;
+
+      col += vec3{ .4f, .4f - std::exp(-rd.y * 20.f) * .15f, 0.f } * std::exp(-rd.y * 9.f); // Red / Green
+      col += vec3{ .3f, .5f, .6f } * (1.f - std::exp(-rd.y * 8.f)) * std::exp(-rd.y * .9f); // Blue
+
+      col = glm::mix(col * 1.2f, vec3{ 0.3f }, 1.f - std::exp(yd * 100.f)); // Fog
+
+      float sunDot = std::max(glm::dot(rd, sunDir), 0.f);
+      col += vec3{ 1.f, .8f, .55f } * std::pow(sunDot, 15.f) * .6f; // Sun
+      col += std::pow(sunDot, 150.f) * .15f;
+
+      return col * skyIntensity;
+   }
+
+   bool RefPathTracer::SavePFM(std::string_view path) const {
+      std::ofstream file{ std::string{ path }, std::ios::binary };
+      if (!file) {
+         WARN("Ref path tracer: can't open '{}'", path);
+         return false;
+      }
+
+      // negative scale - little endian. Rows are stored bottom to top
+      file << "PF\n" << size.x << " " << size.y << "\n-1.0\n";
+      for (u32 y = size.y; y-- > 0;) {
+         file.write((const char*)&image[y * size.x], size.x * sizeof(vec3));
+      }
+
+      return true;
+   }
+
+   bool RefPathTracer::SavePPM(std::string_view path, float exposition) const {
+      std::ofstream file{ std::string{ path }, std::ios::binary };
+      if (!file) {
+         WARN("Ref path tracer: can't open '{}'", path);
+         return false;
+      }
+
+      file << "P6\n" << size.x << " " << size.y << "\n255\n";
+      for (const vec3& color : image) {
+         vec3 mapped = glm::pow(1.f - glm::exp(-color * exposition), vec3{ 1.f / 2.2f });
+         u8 rgb[3];
+         for (int i = 0; i < 3; ++i) {
+            rgb[i] = (u8)(glm::clamp(mapped[i], 0.f, 1.f) * 255.f + 0.5f);
+         }
+         file.write((const char*)rgb, 3);
+      }
+
+      return true;
+   }
+
+   bool RefPathTracer::LoadPFM(std::string_view path, uint2& outSize, std::vector<vec3>& outImage) {
+      std::ifstream file{ std::string{ path }, std::ios::binary };
+      if (!file) {
+         WARN("Ref path tracer: can't open '{}'", path);
+         return false;
+      }
+
+      // only little endian rgb, as written by SavePFM
+      std::string format;
+      float scale = 0;
+      file >> format >> outSize.x >> outSize.y >> scale;
+      file.get(); // single whitespace before data
+      if (!file || format != "PF" || scale >= 0) {
+         WARN("Ref path tracer: '{}' is not a little endian rgb pfm", path);
+         return false;
+      }
+
+      outImage.resize((size_t)outSize.x * outSize.y);
+      for (u32 y = outSize.y; y-- > 0;) {
+         file.read((char*)&outImage[y * outSize.x], outSize.x * sizeof(vec3));
+      }
+
+      if (!file) {
+         WARN("Ref path tracer: '{}' is truncated", path);
+         return false;
+      }
+
+      return true;
+   }
+
+   float RefPathTracer::RMSE(std::span<const vec3> a, std::span<const vec3> b) {
+      ASSERT(a.size() == b.size());
+
+      double sum = 0;
+      for (size_t i = 0; i < a.size(); ++i) {
+         vec3 d = a[i] - b[i];
+         sum += glm::dot(d, d);
+      }
+
+      return a.empty() ? 0.f : (float)std::sqrt(sum / (3.0 * a.size()));
+   }
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "core/Core.h"
+#include "core/Ref.h"
+#include "math/Shape.h"
+#include "math/Types.h"
+#include "shared/rt.hlsli"
+#include "utils/Memory.h"
+
+
+namespace pbe {
+
+   class Scene;
+   struct BVH;
+
+   // objects with geometry and material in the same layout as gRtObjects in rt.hlsl
+   CORE_API void GatherRTObjects(const Scene& scene, std::vector<SRTObject>& objs, std::vector<AABB>& aabbs);
+   // per frame gather, storage is valid until frame arena is reused
+   CORE_API void GatherRTObjects(const Scene& scene, FrameVector<SRTObject>& objs, FrameVector<AABB>& aabbs);
+
+   // CPU port of RayColor from rt.hlsl. Doesn't depend on d3d12, used for image regression tests
+   // and to measure tracing performance on build machines
+   class CORE_API RefPathTracer {
+   public:
+      struct Desc {
+         uint2 size{ 512, 512 };
+         u32 nSamples = 16; // per pixel
+         u32 rayDepth = 2; // same as render/rt/rayDepth
+         u32 tileSize = 16;
+         u32 frameIdx = 0; // random seed, same image for same frameIdx
+      };
+
+      struct Stats {
+         u64 nRays = 0; // including shadow rays
+         float elapsedMs = 0;
+
+         float MRaysPerSec() const { return elapsedMs > 0 ? (float)nRays / elapsedMs / 1000.f : 0; }
+      };
+
+      RefPathTracer();
+      ~RefPathTracer();
+
+      // collects objects and lighting from scene and builds bvh
+      void SetScene(const Scene& scene);
+
+      // linear hdr color, row major, top row first
+      Stats Render(const Desc& desc, const vec3& cameraPos, const mat4& invViewProjection);
+
+      // pfm keeps full float precision, ppm is tonemapped for quick look
+      bool SavePFM(std::string_view path) const;
+      bool SavePPM(std::string_view path, float exposition = 1.f) const;
+      static bool LoadPFM(std::string_view path, uint2& outSize, std::vector<vec3>& outImage);
+
+      // root mean square error between two images of same size
+      static float RMSE(std::span<const vec3> a, std::span<const vec3> b);
+
+      vec3 directLightColor = vec3_Zero;
+      vec3 directLightDirection = vec3{ 1, 0, 0 };
+      float skyIntensity = 0;
+
+      uint2 size{};
+      std::vector<vec3> image;
+
+   private:
+      std::vector<SRTObject> objs;
+      std::vector<AABB> aabbs;
+      Own<BVH> bvh;
+
+      vec3 RayColor(Ray ray, u32 rayDepth, u32& seed, u64& nRays) const;
+      vec3 SkyColor(vec3 rd) const;
+   };
+
+}
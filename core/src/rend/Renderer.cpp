@@ -8,6 +8,8 @@
 #include "Fsr3Upscaler.h"
 #include "RenderContext.h"
 #include "core/CVar.h"
+#include "core/JobSystem.h"
+#include "core/MemoryTracker.h"
 #include "core/Profiler.h"
 #include "math/Random.h"
 #include "math/Shape.h"
@@ -16,6 +18,7 @@
 
 #include "shared/hlslCppShared.hlsli"
 #include "system/Water.h"
+#include "utils/Memory.h"
 
 /// # TODO
 /// - Compile fsr as dll
@@ -33,6 +36,9 @@
 
 
 namespace pbe {
+   // entities per job in render data prepare and instance packing
+   constexpr u32 RENDER_PREPARE_CHUNK_SIZE = 1024;
+
    CVarValue<bool> cFreezeCullCamera{"render/freeze cull camera", false};
    CVarValue<bool> cUseFrustumCulling{"render/use frustum culling", false};
 
@@ -153,63 +159,92 @@ namespace pbe {
    }
 
    void Renderer::UpdateInstanceBuffer(CommandList& cmd, const std::vector<RenderObject>& renderObjs) {
-      if (!instanceBuffer || instanceBuffer->NumElements() < renderObjs.size()) {
-         auto bufferDesc = Buffer::Desc::Structured("instance buffer", (u32)renderObjs.size(), sizeof(SInstance));
-         instanceBuffer = Buffer::Create(bufferDesc);
+      PROFILE_CPU("Update instance buffer");
+
+      u32 nInstances = (u32)renderObjs.size();
+      if (nInstances == 0) {
+         return;
       }
 
-      std::vector<SInstance> instances;
-      instances.reserve(renderObjs.size());
-      for (auto& [trans, material] : renderObjs) {
-         SMaterial m;
-         m.baseColor = material.baseColor;
-         m.roughness = material.roughness;
-         m.metallic = material.metallic;
-         m.emissivePower = material.emissivePower;
-
-         SInstance instance;
-         instance.transform = trans.GetWorldMatrix();
-         instance.prevTransform = trans.GetPrevMatrix();
-         instance.material = m;
-         instance.entityID = (u32)trans.entity.GetEntityID();
-
-         instances.emplace_back(instance);
+      if (!instanceBuffer || instanceBuffer->NumElements() < nInstances) {
+         auto bufferDesc = Buffer::Desc::Structured("instance buffer", nInstances, sizeof(SInstance));
+         instanceBuffer = Buffer::Create(bufferDesc);
       }
 
-      cmd.UpdateBuffer(*instanceBuffer, 0, DataView{ instances });
+      // instances are written directly to upload memory
+      auto* instances = (SInstance*)cmd.UpdateBufferMapped(*instanceBuffer, 0, nInstances * sizeof(SInstance));
+
+      JobSystem::Get().ParallelFor("Pack instances", nInstances, RENDER_PREPARE_CHUNK_SIZE, [&](u32 begin, u32 end) {
+         for (u32 i = begin; i < end; ++i) {
+            const auto& [trans, material] = renderObjs[i];
+
+            SMaterial m;
+            m.baseColor = material->baseColor;
+            m.roughness = material->roughness;
+            m.metallic = material->metallic;
+            m.emissivePower = material->emissivePower;
+
+            SInstance instance;
+            instance.transform = trans->GetWorldMatrix();
+            instance.prevTransform = trans->GetPrevMatrix();
+            instance.material = m;
+            instance.entityID = (u32)trans->entity.GetEntityID();
+
+            instances[i] = instance;
+         }
+      });
    }
 
    void Renderer::RenderDataPrepare(CommandList& cmd, const Scene& scene, const RenderCamera& cullCamera) {
+      PROFILE_CPU("Render data prepare");
+
       opaqueObjs.clear();
       transparentObjs.clear();
 
       // todo:
       Frustum frustum{cullCamera.GetViewProjection()};
+      bool useFrustumCulling = cUseFrustumCulling;
 
-      for (auto [e, sceneTrans, material] :
-           scene.View<SceneTransformComponent, MaterialComponent>().each()) {
-         // DrawDesc desc;
-         // desc.entityID = (u32)e;
-         // desc.transform = sceneTrans.GetMatrix();
-         // desc.material = { material, true };
-         //
-         // drawDescs.push_back(desc);
-
-         if (cUseFrustumCulling) {
-            vec3 scale = sceneTrans.Scale();
-            // todo:
-            float sphereRadius = glm::max(scale.x, scale.y);
-            sphereRadius = glm::max(sphereRadius, scale.z) * 2;
-            if (!frustum.SphereTest({sceneTrans.Position(),})) {
-               continue;
+      auto view = scene.View<SceneTransformComponent, MaterialComponent>();
+      prepareEntities.assign(view.begin(), view.end());
+
+      u32 nEntities = (u32)prepareEntities.size();
+      u32 nChunks = (nEntities + RENDER_PREPARE_CHUNK_SIZE - 1) / RENDER_PREPARE_CHUNK_SIZE;
+      if (prepareChunks.size() < nChunks) {
+         prepareChunks.resize(nChunks);
+      }
+
+      JobSystem::Get().ParallelFor("Render data prepare chunk", nEntities, RENDER_PREPARE_CHUNK_SIZE, [&](u32 begin, u32 end) {
+         auto& chunk = prepareChunks[begin / RENDER_PREPARE_CHUNK_SIZE];
+         chunk.opaque.clear();
+         chunk.transparent.clear();
+
+         for (u32 i = begin; i < end; ++i) {
+            const auto& [sceneTrans, material] = view.get<SceneTransformComponent, MaterialComponent>(prepareEntities[i]);
+
+            if (useFrustumCulling) {
+               vec3 scale = sceneTrans.Scale();
+               // todo:
+               float sphereRadius = glm::max(scale.x, scale.y);
+               sphereRadius = glm::max(sphereRadius, scale.z) * 2;
+               if (!frustum.SphereTest({sceneTrans.Position(), sphereRadius})) {
+                  continue;
+               }
             }
-         }
 
-         if (material.opaque) {
-            opaqueObjs.emplace_back(sceneTrans, material);
-         } else {
-            transparentObjs.emplace_back(sceneTrans, material);
+            if (material.opaque) {
+               chunk.opaque.emplace_back(&sceneTrans, &material);
+            } else {
+               chunk.transparent.emplace_back(&sceneTrans, &material);
+            }
          }
+      });
+
+      // merge in entity order, so result doesn't depend on number of threads
+      for (u32 i = 0; i < nChunks; ++i) {
+         auto& chunk = prepareChunks[i];
+         opaqueObjs.insert(opaqueObjs.end(), chunk.opaque.begin(), chunk.opaque.end());
+         transparentObjs.insert(transparentObjs.end(), chunk.transparent.begin(), chunk.transparent.end());
       }
 
       if (!instanceBuffer || instanceBuffer->NumElements() < scene.EntitiesCount()) {
@@ -220,7 +255,7 @@ namespace pbe {
       {
          auto nLights = (u32)scene.CountEntitiesWithComponents<LightComponent>();
 
-         std::vector<SLight> lights;
+         FrameVector<SLight> lights;
          lights.reserve(nLights);
 
          for (auto [e, trans, light] : scene.View<SceneTransformComponent, LightComponent>().each()) {
@@ -246,12 +281,7 @@ namespace pbe {
          dirs.reserve(nRandomDirs);
 
          for (int i = 0; i < nRandomDirs; ++i) {
-            vec3 test;
-            do {
-               test = Random::Float3(vec3{-1}, vec3{1});
-            } while (glm::length(test) > 1);
-
-            dirs.emplace_back(test);
+            dirs.emplace_back(Random::UniformInSphere());
          }
 
          cmd.UpdateBuffer(*ssaoRandomDirs, 0, DataView{ dirs });
@@ -263,6 +293,7 @@ namespace pbe {
       COMMAND_LIST_SCOPE(cmd, "Render Scene");
       PROFILE_GPU("Render Scene");
       PIX_EVENT_SYSTEM(Render, "Render Scene");
+      MEMORY_TAG(Render);
 
       static RenderCamera cullCamera = camera;
       if (!cFreezeCullCamera) {
@@ -297,12 +328,9 @@ namespace pbe {
 
       u32 nDecals = 0;
       if (cvRenderDecals) {
-         std::vector<SDecal> decals;
+         FrameVector<SDecal> decals;
 
-         MaterialComponent decalDefault{}; // todo:
          for (auto [e, trans, decal] : scene.View<SceneTransformComponent, DecalComponent>().each()) {
-            decalObjs.emplace_back(trans, decalDefault);
-
             vec3 size = trans.Scale() * 0.5f;
 
             mat4 view = glm::lookAt(trans.Position(), trans.Position() + trans.Forward(), trans.Up());
@@ -389,8 +417,8 @@ namespace pbe {
       if (cvRenderOpaqueSort) {
          // todo: slow. I assumed
          std::ranges::sort(opaqueObjs, [&](const RenderObject& a, const RenderObject& b) {
-            float az = glm::dot(camera.Forward(), a.trans.Position());
-            float bz = glm::dot(camera.Forward(), b.trans.Position());
+            float az = glm::dot(camera.Forward(), a.trans->Position());
+            float bz = glm::dot(camera.Forward(), b.trans->Position());
             return az < bz;
          });
       }
@@ -618,8 +646,8 @@ namespace pbe {
             if (cvRenderTransparencySort) {
                // todo: slow. I assumed
                std::ranges::sort(transparentObjs, [&](RenderObject& a, RenderObject& b) {
-                  float az = glm::dot(camera.Forward(), a.trans.Position());
-                  float bz = glm::dot(camera.Forward(), b.trans.Position());
+                  float az = glm::dot(camera.Forward(), a.trans->Position());
+                  float bz = glm::dot(camera.Forward(), b.trans->Position());
                   return az > bz;
                });
             }
@@ -963,12 +991,12 @@ namespace pbe {
 
       for (const auto& [trans, material] : renderObjs) {
          SDrawCallCB cb;
-         cb.instance.transform = glm::translate(mat4(1), trans.Position());
+         cb.instance.transform = glm::translate(mat4(1), trans->Position());
          cb.instance.transform = cb.instance.transform;
-         cb.instance.material.roughness = material.roughness;
-         cb.instance.material.baseColor = material.baseColor;
-         cb.instance.material.metallic = material.metallic;
-         cb.instance.entityID = (u32)trans.entity.GetEntityID();
+         cb.instance.material.roughness = material->roughness;
+         cb.instance.material.baseColor = material->baseColor;
+         cb.instance.material.metallic = material->metallic;
+         cb.instance.entityID = (u32)trans->entity.GetEntityID();
          cb.instanceStart = instanceID++;
          // cb.rdhInstances = instanceBuffer->GetGpuSrv().offset;
 
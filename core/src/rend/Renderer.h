@@ -119,17 +119,23 @@ namespace pbe {
       Water waterSystem;
       Terrain terrainSystem;
 
+      // components are stable while scene is rendered
       struct RenderObject {
-         // todo: component is overkill )
-         // const SceneTransformComponent& trans;
-         // const MaterialComponent& material;
-         SceneTransformComponent trans;
-         MaterialComponent material;
+         const SceneTransformComponent* trans;
+         const MaterialComponent* material;
       };
 
       std::vector<RenderObject> opaqueObjs;
       std::vector<RenderObject> transparentObjs;
-      std::vector<RenderObject> decalObjs;
+
+      // entities are culled in chunks on job system, each chunk keeps its visible objects
+      struct PrepareChunk {
+         std::vector<RenderObject> opaque;
+         std::vector<RenderObject> transparent;
+      };
+
+      std::vector<EntityID> prepareEntities;
+      std::vector<PrepareChunk> prepareChunks;
 
       void Init();
 
@@ -12,6 +12,7 @@
 #include <d3d12shader.h>
 
 #include "core/CVar.h"
+#include "core/MemoryTracker.h"
 #include "core/Profiler.h"
 #include "gui/Gui.h"
 #include "fs/FileWatch.h"
@@ -46,33 +47,37 @@ struct std::hash<std::vector<T>> {
 template<>
 struct std::hash<pbe::ShaderDesc> {
    std::size_t operator()(const pbe::ShaderDesc& v) const {
-      std::size_t res = 0;
-      HashCombine(res, v.entryPoint);
-      HashCombine(res, v.path);
-      HashCombine(res, v.type);
+      Hasher hasher;
+      hasher.Add(v.entryPoint);
+      hasher.Add(v.path);
+      hasher.Add(v.type);
       for (auto& define : v.defines) {
-         HashCombine(res, define);
+         hasher.Add(define);
       }
 
-      HashCombine(res, v.externalBytecode);
-      HashCombine(res, v.externalSize);
+      hasher.Add(v.externalBytecode);
+      hasher.Add(v.externalSize);
 
-      return res;
+      return hasher.Get();
    }
 };
 
 template<>
 struct std::hash<pbe::ProgramDesc> {
    std::size_t operator()(const pbe::ProgramDesc& v) const {
-      std::size_t res = 0;
-      HashCombine(res, v.vs);
-      HashCombine(res, v.hs);
-      HashCombine(res, v.ds);
-      HashCombine(res, v.gs);
-      HashCombine(res, v.ps);
-
-      HashCombine(res, v.cs);
-      return res;
+      std::hash<pbe::ShaderDesc> shaderHash;
+
+      Hasher hasher;
+      hasher.Add(shaderHash(v.as));
+      hasher.Add(shaderHash(v.ms));
+      hasher.Add(shaderHash(v.vs));
+      hasher.Add(shaderHash(v.hs));
+      hasher.Add(shaderHash(v.ds));
+      hasher.Add(shaderHash(v.gs));
+      hasher.Add(shaderHash(v.ps));
+
+      hasher.Add(shaderHash(v.cs));
+      return hasher.Get();
    }
 };
 
@@ -243,6 +248,8 @@ namespace pbe {
    }
 
    bool Shader::Compile(bool force) {
+      MEMORY_TAG(Shader);
+
       if (desc.IsExternal()) {
          // cant recompile external shader
          return true;
@@ -359,8 +366,7 @@ namespace pbe {
 
                // INFO("\tName: {} Type: {} BindPoint: {}", bindDesc.Name, bindDesc.Type, bindDesc.BindPoint);
 
-               size_t id = StrHash(shaderInputBindDesc.Name);
-               reflection[id] = shaderInputBindDesc;
+               reflection[StringID{ shaderInputBindDesc.Name }] = shaderInputBindDesc;
 #if 0
                if (shaderInputBindDesc.Type == D3D_SIT_CBUFFER) {
                   rootParameterIndexMap[stringToWString(shaderInputBindDesc.Name)] = static_cast<uint32_t>(rootParameters.size());
@@ -426,14 +432,12 @@ namespace pbe {
       }
    }
 
-   BindPoint GpuProgram::GetBindPoint(std::string_view name) const {
-      size_t id = StrHash(name);
-
+   BindPoint GpuProgram::GetBindPoint(StringID name) const {
       auto getSlot = [&](const Ref<Shader>& shader) -> BindPoint {
          if (shader) {
-            const auto reflection = shader->reflection;
+            const auto& reflection = shader->reflection;
 
-            auto iter = reflection.find(id);
+            auto iter = reflection.find(name);
             if (iter != reflection.end()) {
                return BindPoint{ iter->second.BindPoint, iter->second.Space };
             }
@@ -455,23 +459,23 @@ namespace pbe {
       return bindPoint;
    }
 
-   void GpuProgram::SetCB(CommandList& cmd, std::string_view name, Buffer& buffer, u32 offsetInBytes) {
+   void GpuProgram::SetCB(CommandList& cmd, StringID name, Buffer& buffer, u32 offsetInBytes) {
       cmd.SetCB(GetBindPoint(name), &buffer, offsetInBytes);
    }
 
-   void GpuProgram::SetSRV(CommandList& cmd, std::string_view name, GpuResource* resource) {
+   void GpuProgram::SetSRV(CommandList& cmd, StringID name, GpuResource* resource) {
       cmd.SetSRV(GetBindPoint(name), resource);
    }
 
-   void GpuProgram::SetSRV(CommandList& cmd, std::string_view name, GpuResource& resource) {
+   void GpuProgram::SetSRV(CommandList& cmd, StringID name, GpuResource& resource) {
       SetSRV(cmd, name, &resource);
    }
 
-   void GpuProgram::SetUAV(CommandList& cmd, std::string_view name, GpuResource* resource) {
+   void GpuProgram::SetUAV(CommandList& cmd, StringID name, GpuResource* resource) {
       cmd.SetUAV(GetBindPoint(name), resource);
    }
 
-   void GpuProgram::SetUAV(CommandList& cmd, std::string_view name, GpuResource& resource) {
+   void GpuProgram::SetUAV(CommandList& cmd, StringID name, GpuResource& resource) {
       SetUAV(cmd, name, &resource);
    }
 
@@ -515,8 +519,8 @@ namespace pbe {
    GpuProgram* GetGpuProgram(const ProgramDesc& desc) {
       auto it = sGpuPrograms.find(desc);
       if (it == sGpuPrograms.end()) {
-         auto program = GpuProgram::Create(desc);
-         sGpuPrograms[desc] = program;
+         auto& program = sGpuPrograms[desc];
+         program = GpuProgram::Create(desc);
          return program.Raw();
       }
 
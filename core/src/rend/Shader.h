@@ -9,6 +9,7 @@
 #include "Common.h"
 #include "core/Core.h"
 #include "core/Ref.h"
+#include "core/StringID.h"
 #include "math/Types.h"
 #include "utils/String.h"
 
@@ -116,7 +117,7 @@ namespace pbe {
 
       std::vector<u8> bytecode;
 
-      std::unordered_map<size_t, D3D12_SHADER_INPUT_BIND_DESC> reflection;
+      std::unordered_map<StringID, D3D12_SHADER_INPUT_BIND_DESC> reflection;
 
       bool Compile(bool force = false);
    };
@@ -204,21 +205,20 @@ namespace pbe {
 
       void Activate(CommandList& cmd);
 
-      // BindPoint GetBindPoint(u64 strID) const;
-      BindPoint GetBindPoint(std::string_view name) const;
+      BindPoint GetBindPoint(StringID name) const;
 
       // todo: remove
       template<typename T>
-      void SetCB(CommandList& cmd, std::string_view name, Buffer& buffer, u32 offsetInBytes = 0) {
+      void SetCB(CommandList& cmd, StringID name, Buffer& buffer, u32 offsetInBytes = 0) {
          SetCB(cmd, name, buffer, offsetInBytes);
       }
-      void SetCB(CommandList& cmd, std::string_view name, Buffer& buffer, u32 offsetInBytes);
+      void SetCB(CommandList& cmd, StringID name, Buffer& buffer, u32 offsetInBytes);
 
-      void SetSRV(CommandList& cmd, std::string_view name, GpuResource* resource);
-      void SetSRV(CommandList& cmd, std::string_view name, GpuResource& resource);
+      void SetSRV(CommandList& cmd, StringID name, GpuResource* resource);
+      void SetSRV(CommandList& cmd, StringID name, GpuResource& resource);
 
-      void SetUAV(CommandList& cmd, std::string_view name, GpuResource* resource = nullptr);
-      void SetUAV(CommandList& cmd, std::string_view name, GpuResource& resource); // todo: remove
+      void SetUAV(CommandList& cmd, StringID name, GpuResource* resource = nullptr);
+      void SetUAV(CommandList& cmd, StringID name, GpuResource& resource); // todo: remove
 
       void DrawInstanced(CommandList& cmd, u32 vertCount, u32 instCount = 1, u32 startVert = 0);
       void DrawIndexedInstanced(CommandList& cmd, u32 indexCount, u32 instCount = 1, u32 indexStart = 0, u32 startVert = 0);
@@ -17,7 +17,15 @@ UploadBuffer::~UploadBuffer() {
 
 UploadBuffer::Allocation UploadBuffer::Allocate(size_t sizeInBytes, size_t alignment) {
    if (sizeInBytes > m_PageSize) {
-      throw std::bad_alloc();
+      // large page of previous frames is reused once per frame, new page is created otherwise
+      std::shared_ptr<Page> page;
+      if (m_LargestPage && m_LargestPage->HasSpace(sizeInBytes, alignment)) {
+         page = std::move(m_LargestPage);
+      } else {
+         page = std::make_shared<Page>(AlignUp(sizeInBytes, alignment));
+      }
+      m_LargePages.push_back(page);
+      return page->Allocate(sizeInBytes, alignment);
    }
 
    // If there is no current page, or the requested allocation exceeds the
@@ -45,6 +53,18 @@ std::shared_ptr<UploadBuffer::Page> UploadBuffer::RequestPage() {
 
 void UploadBuffer::Reset() {
    m_CurrentPage = nullptr;
+
+   // keep only the largest page, big uploads usually repeat every frame
+   for (auto& page : m_LargePages) {
+      if (!m_LargestPage || page->GetSize() > m_LargestPage->GetSize()) {
+         m_LargestPage = page;
+      }
+   }
+   m_LargePages.clear();
+   if (m_LargestPage) {
+      m_LargestPage->Reset();
+   }
+
    // Reset all available pages.
    m_AvailablePages = m_PagePool;
 
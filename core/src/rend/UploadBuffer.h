@@ -30,7 +30,8 @@ namespace pbe {
       virtual ~UploadBuffer();
 
       /**
-       * The maximum size of an allocation is the size of a single page.
+       * Allocations larger than a page get a dedicated page. The largest of them is kept
+       * on Reset and reused by next large allocation that fits it.
        */
       size_t GetPageSize() const {
          return m_PageSize;
@@ -70,6 +71,10 @@ namespace pbe {
          // Reset the page for reuse.
          void Reset();
 
+         size_t GetSize() const {
+            return m_PageSize;
+         }
+
       private:
          Ref<Buffer> m_d3d12Resource;
 
@@ -92,6 +97,9 @@ namespace pbe {
 
       PagePool m_PagePool;
       PagePool m_AvailablePages;
+      PagePool m_LargePages;
+      // kept between frames, not in m_LargePages until it is reused
+      std::shared_ptr<Page> m_LargestPage;
 
       std::shared_ptr<Page> m_CurrentPage;
 
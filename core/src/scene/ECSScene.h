@@ -21,6 +21,14 @@ namespace pbe {
          return registry.emplace<T>(id, std::forward<Cs>(cs)...);
       }
 
+      // components are moved from range [from, from + (last - first)), entities must not have component
+      template<typename T, typename EntityIt, typename ComponentIt>
+      void InsertComponents(EntityIt first, EntityIt last, ComponentIt from) {
+         auto& storage = registry.storage<T>();
+         storage.reserve(storage.size() + (size_t)std::distance(first, last));
+         registry.insert<T>(first, last, std::make_move_iterator(from));
+      }
+
       template<typename T, typename...Cs>
       decltype(auto) AddOrReplaceComponent(EntityID id, Cs&&... cs) {
          return registry.emplace_or_replace<T>(id, std::forward<Cs>(cs)...);
@@ -80,6 +88,16 @@ namespace pbe {
          registry.clear<Component>();
       }
 
+      // func(storageID) for each storage containing entity, storage id of component is its TypeID
+      template<typename Func>
+      void ForEachStorageOf(EntityID id, Func&& func) const {
+         for (auto [storageID, storage] : registry.storage()) {
+            if (storage.contains(id)) {
+               func(storageID);
+            }
+         }
+      }
+
       // todo: it strange and may be not needed
       template<typename... Exclude>
       void RemoveAllComponents(EntityID id) {
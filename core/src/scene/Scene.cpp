@@ -3,6 +3,9 @@
 
 #include "Component.h"
 #include "Entity.h"
+#include "core/JobSystem.h"
+#include "core/MemoryTracker.h"
+#include "core/Profiler.h"
 #include "typer/Typer.h"
 #include "fs/FileSystem.h"
 #include "rend/DbgRend.h"
@@ -57,7 +60,7 @@ namespace pbe {
 
    Entity Scene::GetEntity(UUID uuid) {
       auto it = uuidToEntities.find(uuid);
-      return it == uuidToEntities.end() ? Entity{} : Entity{ uuidToEntities[(u64)uuid], this };
+      return it == uuidToEntities.end() ? Entity{} : Entity{ it->second, this };
    }
 
    Entity Scene::GetRootEntity() {
@@ -144,6 +147,8 @@ namespace pbe {
    }
 
    void Scene::OnSync() {
+      PROFILE_CPU("Scene sync");
+
       // destroy delayed entities
       for (auto e : registry.view<DelayedDestroyMarker>()) {
          DestroyImmediate(e);
@@ -154,17 +159,60 @@ namespace pbe {
    }
 
    void Scene::OnTick() {
+      MEMORY_TAG(Scene);
       OnSync();
 
       // sync phys scene with changed transforms outside physics
       GetPhysics()->SyncPhysicsWithScene();
       ClearComponent<TransformChangedMarker>();
 
+      UpdateWorldTransforms();
+
       for (auto [entityID, trans] : View<SceneTransformComponent>().each()) {
          trans.UpdatePrevTransform();
       }
    }
 
+   void Scene::UpdateWorldTransforms() {
+      PROFILE_CPU("Update world transforms");
+
+      // only subtrees of entities marked dirty are walked
+      for (EntityID rootID : dirtyTransformRoots) {
+         if (!registry.valid(rootID)) {
+            continue;
+         }
+
+         auto* rootTrans = registry.try_get<SceneTransformComponent>(rootID);
+         // already resolved with subtree of other root or will be resolved with its dirty parent
+         if (!rootTrans || !rootTrans->worldDirty
+            || rootTrans->parent && rootTrans->parent.Get<SceneTransformComponent>().worldDirty) {
+            continue;
+         }
+
+         // depth first, parent world is always valid when child is processed
+         transformUpdateStack.clear();
+         transformUpdateStack.push_back(rootID);
+
+         while (!transformUpdateStack.empty()) {
+            EntityID entityID = transformUpdateStack.back();
+            transformUpdateStack.pop_back();
+
+            auto& trans = registry.get<SceneTransformComponent>(entityID);
+            trans.world = trans.parent
+               ? trans.parent.Get<SceneTransformComponent>().world * trans.local
+               : trans.local;
+            trans.worldDirty = false;
+
+            // children of dirty entity are dirty too
+            for (auto child : trans.children) {
+               transformUpdateStack.push_back(child.GetEntityID());
+            }
+         }
+      }
+
+      dirtyTransformRoots.clear();
+   }
+
    void Scene::OnStart() {
       const auto& typer = Typer::Get();
 
@@ -178,6 +226,8 @@ namespace pbe {
    }
 
    void Scene::OnUpdate(float dt) {
+      MEMORY_TAG(Scene);
+
       for (auto [entityID, td] : View<TimedDieComponent>().each()) {
          td.time -= dt;
          if (td.time < 0.f) {
@@ -190,11 +240,18 @@ namespace pbe {
          system->OnUpdate(dt);
       }
 
-      const auto& typer = Typer::Get();
+      {
+         PROFILE_CPU("Scripts update");
+         MEMORY_TAG(Script);
 
-      for (const auto& si : typer.scripts) {
-         si.sceneApplyFunc(*this, [dt](Entity entity, Script& script) { script.OnUpdate(dt); });
+         const auto& typer = Typer::Get();
+         for (const auto& si : typer.scripts) {
+            si.sceneApplyFunc(*this, [dt](Entity entity, Script& script) { script.OnUpdate(dt); });
+         }
       }
+
+      // systems and scripts moved entities, resolve before render
+      UpdateWorldTransforms();
    }
 
    void Scene::OnStop() {
@@ -241,13 +298,17 @@ namespace pbe {
       return gCurrentDeserializedScene;
    }
 
+   void Scene::SetCurrentDeserializedScene(Scene* scene) {
+      gCurrentDeserializedScene = scene;
+   }
+
    Entity Scene::CreateWithUUID(UUID uuid, const Entity& parent, std::string_view name) {
       auto entityID = registry.create();
 
       auto entity = Entity{ entityID, this };
       entity.Add<UUIDComponent>(uuid);
       if (!name.empty()) {
-         entity.Add<TagComponent>(name.data());
+         entity.Add<TagComponent>(std::string{ name });
       }
       else {
          // todo: support entity without name
@@ -346,22 +407,19 @@ namespace pbe {
 
          const auto& typer = Typer::Get();
 
-         // todo: use entt for iterate components
-         for (const auto& ci : typer.components) {
-            auto* pSrc = ci.tryGetConst(src);
-            if (!pSrc) {
-               continue;
-            }
+         typer.GetComponentMask(src).ForEach([&](u32 componentIdx) {
+            const auto& ci = typer.components[componentIdx];
 
+            auto* pSrc = ci.tryGetConst(src);
             auto pDst = ci.copyCtor(dst, pSrc);
 
-            const auto& ti = typer.GetTypeInfo(ci.typeID);
+            const auto& ti = typer.GetTypeInfoByIndex(ci.typeIndex);
             if (!ti.hasEntityRef) {
-               continue;
+               return;
             }
 
             for (const auto& field : ti.fields) {
-               auto& filedTypeInfo = typer.GetTypeInfo(field.typeID);
+               auto& filedTypeInfo = typer.GetTypeInfoByIndex(field.typeIndex);
 
                if (filedTypeInfo.hasEntityRef) {
                   // todo: while dont support nested entity ref
@@ -381,7 +439,7 @@ namespace pbe {
                   }
                }
             }
-         }
+         });
          });
 
       // todo: mb create set with enabled entities?
@@ -399,7 +457,17 @@ namespace pbe {
       return gAssetsPath + path.data();
    }
 
+   bool IsBinaryScenePath(std::string_view path) {
+      return fs::path{ path }.extension() == ".scnb";
+   }
+
    void SceneSerialize(std::string_view path, Scene& scene) {
+      if (IsBinaryScenePath(path)) {
+         SceneSerializeBinary(path, scene);
+         return;
+      }
+
+      MEMORY_TAG(Serialize);
       Serializer ser;
 
       {
@@ -431,7 +499,16 @@ namespace pbe {
       ser.SaveToFile(path);
    }
 
+   // components of one type decoded by one job
+   constexpr u32 SceneLoadBatchSize = 128;
+
    Own<Scene> SceneDeserialize(std::string_view path) {
+      if (IsBinaryScenePath(path)) {
+         return SceneDeserializeBinary(path);
+      }
+
+      PROFILE_CPU("SceneDeserialize");
+      MEMORY_TAG(Serialize);
       INFO("Deserialize scene '{}'", path);
 
       if (!fs::exists(path)) {
@@ -439,51 +516,207 @@ namespace pbe {
          return {};
       }
 
+      CpuTimer timer;
+
+      // todo:
+      // GetAssetsPath(path);
+      auto deser = std::invoke([&] {
+         PROFILE_CPU("Parse");
+         return Deserializer::FromFile(path);
+      });
+      float parseMs = timer.ElapsedMs(true);
+
       Own<Scene> scene = std::make_unique<Scene>(false);
 
       gCurrentDeserializedScene = scene.get();
 
-      // todo:
-      // GetAssetsPath(path);
-      auto deser = Deserializer::FromFile(path);
+      const auto& typer = Typer::Get();
+
+      // nodes of one component type, decoded to staging by jobs and inserted to registry at once
+      struct ComponentLoad {
+         std::vector<EntityID> entities;
+         std::vector<Deserializer> nodes;
+         Own<ComponentStaging> staging;
+      };
+
+      std::vector<ComponentLoad> loads(typer.components.size());
 
-      // auto sceneName = deser["sceneName"].As<string>();
+      std::vector<std::pair<Entity, Deserializer>> transforms;
+      std::vector<EntityID> enabledEntities;
 
       auto entitiesNode = deser["entities"];
+      u32 nEntities = (u32)entitiesNode.Size();
+
+      // all entities are created before components, components may reference any of them
+      {
+         PROFILE_CPU("Create entities");
+
+         transforms.reserve(nEntities);
+         enabledEntities.reserve(nEntities);
+
+         std::vector<std::pair<u32, Deserializer>> entityComponents;
+
+         for (u32 i = 0; i < nEntities; ++i) {
+            auto it = entitiesNode[i];
+
+            u64 uuid = 0;
+            string entityTag;
+            bool enabled = true;
+            std::optional<Deserializer> transformNode;
+            entityComponents.clear();
+
+            it.ForEach([&](std::string_view key, const Deserializer& value) {
+               if (key == "uuid") {
+                  uuid = value.As<u64>();
+               } else if (key == "tag") {
+                  entityTag = value.As<string>();
+               } else if (key == "disabled") {
+                  enabled = false;
+               } else if (key == "SceneTransformComponent") {
+                  transformNode = value;
+               } else if (const auto* ci = typer.FindComponent(key)) {
+                  entityComponents.emplace_back(ci->index, value);
+               }
+            });
+
+            Entity entity = scene->CreateWithUUID(UUID{ uuid }, Entity{}, entityTag);
+            entity.Get<TagComponent>().tag = entityTag;
+            scene->EntityDisableImmediate(entity);
+
+            if (transformNode) {
+               transforms.emplace_back(entity, *transformNode);
+            }
+            if (enabled) {
+               enabledEntities.emplace_back(entity.GetEntityID());
+            }
 
-      // on first iteration create all entities
-      for (int i = 0; i < entitiesNode.Size(); ++i) {
-         auto it = entitiesNode[i];
+            for (auto& [idx, node] : entityComponents) {
+               loads[idx].entities.emplace_back(entity.GetEntityID());
+               loads[idx].nodes.emplace_back(std::move(node));
+            }
+         }
+      }
+      float createMs = timer.ElapsedMs(true);
+
+      struct Batch {
+         u32 loadIdx;
+         u32 begin;
+         u32 end;
+         bool failed = false;
+      };
+
+      std::vector<Batch> batches;
+      u32 nComponents = 0;
+
+      // yaml-cpp is not thread safe even for const reads, missing key may allocate in document memory.
+      // Component nodes are cloned on this thread, so each job reads only nodes nobody else touches
+      {
+         PROFILE_CPU("Clone component nodes");
+
+         for (u32 loadIdx = 0; loadIdx < (u32)loads.size(); ++loadIdx) {
+            auto& load = loads[loadIdx];
+            u32 count = (u32)load.entities.size();
+            if (count == 0) {
+               continue;
+            }
+
+            for (auto& node : load.nodes) {
+               node = node.Clone();
+            }
+
+            load.staging = typer.components[loadIdx].createStaging(count);
+            for (u32 begin = 0; begin < count; begin += SceneLoadBatchSize) {
+               batches.push_back({ loadIdx, begin, std::min(begin + SceneLoadBatchSize, count) });
+            }
+            nComponents += count;
+         }
+      }
+
+      // jobs only read cloned nodes of own components and uuid map of scene, registry is not touched until insert
+      auto& jobSystem = JobSystem::Get();
+      JobCounter decodeCounter;
+
+      for (auto& batch : batches) {
+         jobSystem.Run("Decode components", [&, &batch = batch] {
+            // exception must not leave worker, it fails the load after wait
+            try {
+               const auto& load = loads[batch.loadIdx];
+               const auto& ti = typer.GetTypeInfoByIndex(typer.components[batch.loadIdx].typeIndex);
 
-         auto uuid = it["uuid"].As<u64>();
+               for (u32 i = batch.begin; i < batch.end; ++i) {
+                  typer.Deserialize(load.nodes[i], "", ti, load.staging->At(i));
+               }
+            } catch (const std::exception& e) {
+               WARN("Failed to decode '{}': {}", typer.GetTypeInfoByIndex(typer.components[batch.loadIdx].typeIndex).name, e.what());
+               batch.failed = true;
+            }
+         }, &decodeCounter);
+      }
 
-         string entityTag;
-         if (it["tag"]) {
-            entityTag = it["tag"].As<string>();
+      // hierarchy is restored on this thread from original document while components are decoded
+      {
+         PROFILE_CPU("Transforms");
+
+         for (auto& [entity, node] : transforms) {
+            node.Deser("", entity.GetTransform());
          }
+      }
 
-         Entity entity = scene->CreateWithUUID(UUID{ uuid }, Entity{}, entityTag);
-         scene->EntityDisableImmediate(entity);
+      {
+         PROFILE_CPU("Wait components decode");
+         jobSystem.Wait(decodeCounter);
       }
 
-      // on second iteration create all components
-      for (int i = 0; i < entitiesNode.Size(); ++i) {
-         auto it = entitiesNode[i];
-         EntityDeserialize(it, *scene);
+      if (std::ranges::any_of(batches, &Batch::failed)) {
+         WARN("Scene '{}' failed to load", path);
+         gCurrentDeserializedScene = nullptr;
+         return {};
       }
+      float decodeMs = timer.ElapsedMs(true);
 
+      {
+         PROFILE_CPU("Insert components");
+
+         for (auto& load : loads) {
+            if (load.staging) {
+               load.staging->Insert(*scene, load.entities);
+            }
+         }
+      }
+      float insertMs = timer.ElapsedMs(true);
+
+      {
+         PROFILE_CPU("Enable");
+
+         for (auto entityID : enabledEntities) {
+            scene->EntityEnable(entityID, true, false);
+         }
+
+         scene->OnDeserialized();
+      }
+      float enableMs = timer.ElapsedMs(true);
+
+      gCurrentDeserializedScene = nullptr;
+
+      INFO("Scene loaded, {} entities, {} components in {} batches. Parse {:.1f} ms, create {:.1f} ms, decode {:.1f} ms, insert {:.1f} ms, enable {:.1f} ms",
+         nEntities, nComponents, batches.size(), parseMs, createMs, decodeMs, insertMs, enableMs);
+
+      return scene;
+   }
+
+   void Scene::OnDeserialized() {
       entt::entity rootEntityId = entt::null;
-      for (auto [e, trans] : scene->ViewAll<SceneTransformComponent>().each()) {
+      for (auto [e, trans] : ViewAll<SceneTransformComponent>().each()) {
          if (trans.parent) {
             continue;
          }
 
          if (rootEntityId != entt::null) {
             WARN("Scene has several roots. Create new root and parenting to it all entities without parent");
-            auto newRoot = scene->CreateWithUUID(UUID{}, Entity{}, "Scene");
+            auto newRoot = CreateWithUUID(UUID{}, Entity{}, "Scene");
             rootEntityId = newRoot.GetEntityID();
 
-            for (auto [e, trans] : scene->ViewAll<SceneTransformComponent>().each()) {
+            for (auto [e, trans] : ViewAll<SceneTransformComponent>().each()) {
                if (!trans.parent) {
                   trans.SetParent(newRoot);
                }
@@ -497,14 +730,20 @@ namespace pbe {
          // break;
       }
 
-      Entity rootEntity = { rootEntityId, scene.get() };
-      scene->SetRootEntity(rootEntity);
+      Entity rootEntity = { rootEntityId, this };
+      SetRootEntity(rootEntity);
 
-      scene->ProcessDelayedEnable();
+      ProcessDelayedEnable();
+   }
 
-      gCurrentDeserializedScene = nullptr;
+   bool SceneConvert(std::string_view srcPath, std::string_view dstPath) {
+      auto scene = SceneDeserialize(srcPath);
+      if (!scene) {
+         return false;
+      }
 
-      return scene;
+      SceneSerialize(dstPath, *scene);
+      return true;
    }
 
    void EntitySerialize(Serializer& ser, const Entity& entity) {
@@ -527,15 +766,13 @@ namespace pbe {
 
          const auto& typer = Typer::Get();
 
-         for (const auto& ci : typer.components) {
-            const auto& ti = typer.GetTypeInfo(ci.typeID);
+         typer.GetComponentMask(entity).ForEach([&](u32 componentIdx) {
+            const auto& ci = typer.components[componentIdx];
+            const auto& ti = typer.GetTypeInfoByIndex(ci.typeIndex);
 
-            auto* ptr = (u8*)ci.tryGetConst(entity);
-            if (ptr) {
-               const char* name = ti.name.data();
-               ser.Ser(name, ci.typeID, ptr);
-            }
-         }
+            auto* ptr = (const u8*)ci.tryGetConst(entity);
+            typer.Serialize(ser, ti.name, ti, ptr);
+         });
       }
    }
 
@@ -568,21 +805,13 @@ namespace pbe {
 
       const auto& typer = Typer::Get();
 
-      // std::array<u8, 128> data; // todo:
-
-      for (const auto& ci : typer.components) {
-         const auto& ti = typer.GetTypeInfo(ci.typeID);
-
-         // ASSERT(ti.typeSizeOf < data.size());
-
-         const char* name = ti.name.data();
-
-         if (auto node = deser[name]) {
+      deser.ForEach([&](std::string_view key, const Deserializer& value) {
+         if (const auto* ci = typer.FindComponent(key)) {
             // todo: use move ctor
-            auto* ptr = (u8*)ci.getOrAdd(entity);
-            deser.Deser(name, ci.typeID, ptr);
+            auto* ptr = (u8*)ci->getOrAdd(entity);
+            typer.Deserialize(value, "", typer.GetTypeInfoByIndex(ci->typeIndex), ptr);
          }
-      }
+      });
 
       if (enabled) {
          entity.GetScene()->EntityEnable(entity.GetEntityID(), true, false);
@@ -19,6 +19,7 @@ namespace pbe {
    class UUID;
 
    class Entity;
+   struct SceneTransformComponent;
 
    class CORE_API Scene : public ECSScene, public SceneDataStorage {
    public:
@@ -118,8 +119,8 @@ namespace pbe {
          ASSERT(!componentEventMap.contains(typeID));
          componentEventMap[typeID] = std::move(handlers);
 
-         registry.on_construct<Comp>().connect<&Scene::OnComponentConstruct<Comp>>(this);
-         registry.on_destroy<Comp>().connect<&Scene::OnComponentDestroy<Comp>>(this);
+         registry.on_construct<Comp>().template connect<&Scene::OnComponentConstruct<Comp>>(this);
+         registry.on_destroy<Comp>().template connect<&Scene::OnComponentDestroy<Comp>>(this);
       }
 
       template<typename Comp, typename OnUpdateT>
@@ -129,7 +130,7 @@ namespace pbe {
          ComponentEventHandlers& handlers = componentEventMap[typeID];
 
          if (handlers.onUpdates.empty()) {
-            registry.on_update<Comp>().connect<&Scene::OnComponentUpdate<Comp>>(this);
+            registry.on_update<Comp>().template connect<&Scene::OnComponentUpdate<Comp>>(this);
          }
 
          handlers.onUpdates.push_back(onUpdateF);
@@ -141,6 +142,9 @@ namespace pbe {
       // call this every frame
       void OnTick();
 
+      // recomputes cached world transforms of dirty subtrees, parents before children
+      void UpdateWorldTransforms();
+
       void OnStart();
       void OnUpdate(float dt);
       void OnStop();
@@ -163,6 +167,10 @@ namespace pbe {
 
       std::unordered_map<u64, entt::entity> uuidToEntities;
 
+      // topmost entities whose world transform was marked dirty since last update
+      std::vector<EntityID> dirtyTransformRoots;
+      std::vector<EntityID> transformUpdateStack;
+
       // todo: move to scene component?
       std::vector<Own<System>> systems;
 
@@ -171,18 +179,34 @@ namespace pbe {
 
       void ProcessDelayedEnable();
 
+      // root setup and enabling after all entities are loaded
+      void OnDeserialized();
+      static void SetCurrentDeserializedScene(Scene* scene);
+
       void EntityDisableImmediate(Entity& entity);
 
       void DuplicateHier(Entity& dst, const Entity& src, bool copyUUID);
 
       friend Entity;
+      friend SceneTransformComponent;
       friend CORE_API Own<Scene> SceneDeserialize(std::string_view path);
+      friend CORE_API Own<Scene> SceneDeserializeBinary(std::string_view path);
       friend CORE_API void EntityDeserialize(const Deserializer& deser, Scene& scene);
    };
 
+   // format by extension: .scn - yaml, .scnb - binary
    CORE_API void SceneSerialize(std::string_view path, Scene& scene);
    CORE_API Own<Scene> SceneDeserialize(std::string_view path);
 
+   // binary scene is fast to load and is read from mapped file. Yaml stays editable interchange format,
+   // binary data of component is skipped if its type layout changed since saving
+   CORE_API bool IsBinaryScenePath(std::string_view path);
+   CORE_API void SceneSerializeBinary(std::string_view path, Scene& scene);
+   CORE_API Own<Scene> SceneDeserializeBinary(std::string_view path);
+
+   // converts between formats, e.g. SceneConvert("a.scn", "a.scnb")
+   CORE_API bool SceneConvert(std::string_view srcPath, std::string_view dstPath);
+
    // todo: move to Entity.h
    CORE_API void EntitySerialize(Serializer& ser, const Entity& entity);
    CORE_API void EntityDeserialize(const Deserializer& deser, Scene& scene);
@@ -0,0 +1,417 @@
+#include "pch.h"
+#include "Scene.h"
+
+#include "Component.h"
+#include "Entity.h"
+#include "core/JobSystem.h"
+#include "core/MemoryTracker.h"
+#include "core/Profiler.h"
+#include "fs/FileSystem.h"
+#include "typer/BinarySerialize.h"
+#include "typer/Typer.h"
+
+namespace pbe {
+
+   // file layout:
+   //    header
+   //    string table: u32 offsets[nStrings + 1], chars
+   //    entities: u64 uuids[n], u32 tags[n], u8 flags[n]
+   //    component blocks: ComponentBlockHeader, u32 entityIdxs[nEntities], data
+
+   constexpr u32 SceneBinaryMagic = 0x53454250; // "PBES"
+   constexpr u32 SceneBinaryVersion = 1;
+
+   struct SceneBinaryHeader {
+      u32 magic = SceneBinaryMagic;
+      u32 version = SceneBinaryVersion;
+      u32 nEntities = 0;
+      u32 nStrings = 0;
+      u32 nComponentBlocks = 0;
+      u32 _pad = 0;
+      u64 stringsOffset = 0;
+      u64 entitiesOffset = 0;
+      u64 componentsOffset = 0;
+   };
+
+   struct ComponentBlockHeader {
+      u32 nameIdx;
+      u32 nEntities;
+      u64 schemaHash;
+      u64 dataSize;
+   };
+
+   enum SceneBinaryEntityFlags : u8 {
+      EntityDisabled = BIT(0),
+   };
+
+   void SceneSerializeBinary(std::string_view path, Scene& scene) {
+      PROFILE_CPU("SceneSerializeBinary");
+      MEMORY_TAG(Serialize);
+
+      const auto& typer = Typer::Get();
+
+      std::vector<u64> entitiesUuids;
+      for (auto [_, uuid] : scene.ViewAll<UUIDComponent>().each()) {
+         entitiesUuids.emplace_back((u64)uuid.uuid);
+      }
+      std::ranges::sort(entitiesUuids);
+
+      std::vector<Entity> entities;
+      entities.reserve(entitiesUuids.size());
+      for (auto uuid : entitiesUuids) {
+         entities.emplace_back(scene.GetEntity(uuid));
+      }
+
+      u32 nEntities = (u32)entities.size();
+
+      BinaryWriter body;
+
+      // entities
+      body.WriteBytes(entitiesUuids.data(), entitiesUuids.size() * sizeof(u64));
+      for (const auto& entity : entities) {
+         const auto* tag = entity.TryGet<TagComponent>();
+         body.WriteString(tag ? std::string_view{ tag->tag } : std::string_view{});
+      }
+      for (const auto& entity : entities) {
+         u8 flags = entity.Enabled() ? 0 : EntityDisabled;
+         body.Write(flags);
+      }
+
+      u64 componentsOffset = body.buffer.size();
+      u32 nComponentBlocks = 0;
+
+      std::vector<u32> entityIdxs;
+      std::vector<const u8*> components;
+
+      auto writeBlock = [&](const TypeInfo& ti, auto&& tryGetConst) {
+         entityIdxs.clear();
+         components.clear();
+
+         for (u32 i = 0; i < nEntities; ++i) {
+            if (const u8* ptr = (const u8*)tryGetConst(entities[i])) {
+               entityIdxs.emplace_back(i);
+               components.emplace_back(ptr);
+            }
+         }
+
+         if (entityIdxs.empty()) {
+            return;
+         }
+
+         ComponentBlockHeader blockHeader{
+            .nameIdx = body.AddString(ti.name),
+            .nEntities = (u32)entityIdxs.size(),
+            .schemaHash = ti.binarySchemaHash,
+            .dataSize = 0,
+         };
+
+         size_t blockHeaderPos = body.buffer.size();
+         body.Write(blockHeader);
+         body.WriteBytes(entityIdxs.data(), entityIdxs.size() * sizeof(u32));
+
+         size_t dataBegin = body.buffer.size();
+         if (ti.podBinaryOp) {
+            const auto& op = *ti.podBinaryOp;
+            body.buffer.reserve(dataBegin + components.size() * op.size);
+            for (const u8* ptr : components) {
+               body.WriteBytes(ptr + op.offset, op.size);
+            }
+         } else {
+            for (const u8* ptr : components) {
+               typer.SerializeBin(body, ti, ptr);
+            }
+         }
+
+         blockHeader.dataSize = body.buffer.size() - dataBegin;
+         memcpy(body.buffer.data() + blockHeaderPos, &blockHeader, sizeof(blockHeader));
+
+         ++nComponentBlocks;
+      };
+
+      // transforms first, components may reference hierarchy
+      writeBlock(typer.GetTypeInfo<SceneTransformComponent>(), [](const Entity& e) { return &e.GetTransform(); });
+
+      for (const auto& ci : typer.components) {
+         writeBlock(typer.GetTypeInfoByIndex(ci.typeIndex), ci.tryGetConst);
+      }
+
+      // string table
+      std::vector<u32> stringOffsets;
+      stringOffsets.reserve(body.strings.size() + 1);
+      u32 stringsSize = 0;
+      for (auto str : body.strings) {
+         stringOffsets.emplace_back(stringsSize);
+         stringsSize += (u32)str.size();
+      }
+      stringOffsets.emplace_back(stringsSize);
+
+      SceneBinaryHeader header;
+      header.nEntities = nEntities;
+      header.nStrings = (u32)body.strings.size();
+      header.nComponentBlocks = nComponentBlocks;
+      header.stringsOffset = sizeof(SceneBinaryHeader);
+      header.entitiesOffset = header.stringsOffset + stringOffsets.size() * sizeof(u32) + stringsSize;
+      header.componentsOffset = header.entitiesOffset + componentsOffset;
+
+      std::ofstream file{ std::string{ path }, std::ios::binary };
+      if (!file) {
+         WARN("Cant open file '{}' for writing", path);
+         return;
+      }
+
+      file.write((const char*)&header, sizeof(header));
+      file.write((const char*)stringOffsets.data(), stringOffsets.size() * sizeof(u32));
+      for (auto str : body.strings) {
+         file.write(str.data(), str.size());
+      }
+      file.write((const char*)body.buffer.data(), body.buffer.size());
+   }
+
+   Own<Scene> SceneDeserializeBinary(std::string_view path) {
+      PROFILE_CPU("SceneDeserializeBinary");
+      MEMORY_TAG(Serialize);
+      INFO("Deserialize binary scene '{}'", path);
+
+      MappedFile file{ path };
+      if (!file.Valid()) {
+         WARN("Cant open file '{}'", path);
+         return {};
+      }
+
+      BinaryReader reader{ file.Data(), file.Size() };
+
+      auto header = reader.Read<SceneBinaryHeader>();
+      if (reader.Failed() || header.magic != SceneBinaryMagic) {
+         WARN("'{}' is not binary scene", path);
+         return {};
+      }
+      if (header.version != SceneBinaryVersion) {
+         WARN("Binary scene '{}' has version {}, expected {}. Convert it from yaml again", path, header.version, SceneBinaryVersion);
+         return {};
+      }
+
+      // string table points into mapped file
+      reader.pos = header.stringsOffset;
+      reader.stringOffsets = (const u32*)reader.SkipArray((u64)header.nStrings + 1, sizeof(u32));
+      if (reader.Failed()) {
+         WARN("Binary scene '{}' is corrupted", path);
+         return {};
+      }
+
+      // offsets are checked once, then any string index below nStrings is in bounds
+      bool validOffsets = true;
+      for (u32 i = 0; i < header.nStrings; ++i) {
+         validOffsets &= reader.stringOffsets[i] <= reader.stringOffsets[i + 1];
+      }
+      if (!validOffsets || !reader.Has(reader.stringOffsets[header.nStrings])) {
+         WARN("Binary scene '{}' is corrupted", path);
+         return {};
+      }
+
+      reader.stringData = (const char*)reader.data + reader.pos;
+      reader.nStrings = header.nStrings;
+
+      u32 nEntities = header.nEntities;
+
+      reader.pos = header.entitiesOffset;
+      const u8* uuids = reader.SkipArray(nEntities, sizeof(u64));
+      const u8* tags = reader.SkipArray(nEntities, sizeof(u32));
+      const u8* flags = reader.SkipArray(nEntities, sizeof(u8));
+      if (reader.Failed()) {
+         WARN("Binary scene '{}' is corrupted", path);
+         return {};
+      }
+
+      Own<Scene> scene = std::make_unique<Scene>(false);
+      Scene::SetCurrentDeserializedScene(scene.get());
+
+      std::vector<Entity> entities(nEntities);
+
+      {
+         PROFILE_CPU("Create entities");
+
+         for (u32 i = 0; i < nEntities; ++i) {
+            u64 uuid;
+            u32 tagIdx;
+            memcpy(&uuid, uuids + i * sizeof(u64), sizeof(u64));
+            memcpy(&tagIdx, tags + i * sizeof(u32), sizeof(u32));
+
+            auto tag = reader.GetString(tagIdx);
+
+            Entity entity = scene->CreateWithUUID(UUID{ uuid }, Entity{}, tag);
+            entity.Get<TagComponent>().tag = tag;
+            scene->EntityDisableImmediate(entity);
+            entities[i] = entity;
+         }
+      }
+
+      const auto& typer = Typer::Get();
+
+      // block of one component type, decoded to staging by job and inserted to registry at once
+      struct ComponentLoad {
+         std::string_view name;
+         u32 componentIdx;
+         BinaryReader reader;
+         std::vector<EntityID> entities;
+         Own<ComponentStaging> staging;
+         bool failed = false;
+      };
+
+      std::vector<ComponentLoad> loads;
+      std::optional<ComponentLoad> transformLoad;
+
+      {
+         PROFILE_CPU("Component blocks");
+
+         reader.pos = header.componentsOffset;
+
+         for (u32 iBlock = 0; iBlock < header.nComponentBlocks; ++iBlock) {
+            auto blockHeader = reader.Read<ComponentBlockHeader>();
+            const u8* entityIdxs = reader.SkipArray(blockHeader.nEntities, sizeof(u32));
+            const u8* data = reader.SkipArray(blockHeader.dataSize, sizeof(u8));
+            // entity has at most one component of each type
+            if (reader.Failed() || blockHeader.nEntities > nEntities) {
+               WARN("Binary scene '{}' is corrupted", path);
+               break;
+            }
+
+            auto name = reader.GetString(blockHeader.nameIdx);
+
+            bool isTransform = name == "SceneTransformComponent";
+            const ComponentInfo* ci = isTransform ? nullptr : typer.FindComponent(name);
+
+            if (!isTransform && !ci) {
+               WARN("Unknown component '{}' in binary scene, skipped", name);
+               continue;
+            }
+
+            const auto& ti = isTransform ? typer.GetTypeInfo<SceneTransformComponent>() : typer.GetTypeInfoByIndex(ci->typeIndex);
+            if (ti.binarySchemaHash != blockHeader.schemaHash) {
+               WARN("Layout of '{}' changed since binary scene was saved, component skipped. Convert scene from yaml again", name);
+               continue;
+            }
+
+            ComponentLoad load{
+               .name = name,
+               .componentIdx = isTransform ? InvalidTypeIndex : ci->index,
+               .reader = reader,
+               .entities = {},
+               .staging = {},
+               .failed = false,
+            };
+            load.reader.data = data;
+            load.reader.size = blockHeader.dataSize;
+            load.reader.pos = 0;
+
+            load.entities.resize(blockHeader.nEntities);
+            bool validIdxs = true;
+            for (u32 i = 0; i < blockHeader.nEntities; ++i) {
+               u32 entityIdx;
+               memcpy(&entityIdx, entityIdxs + i * sizeof(u32), sizeof(u32));
+               validIdxs &= entityIdx < nEntities;
+               load.entities[i] = validIdxs ? entities[entityIdx].GetEntityID() : NullEntityID;
+            }
+
+            if (!validIdxs) {
+               WARN("Binary data of '{}' is corrupted", name);
+               continue;
+            }
+
+            if (isTransform) {
+               transformLoad = std::move(load);
+            } else {
+               load.staging = ci->createStaging(blockHeader.nEntities);
+               loads.emplace_back(std::move(load));
+            }
+         }
+      }
+
+      auto checkLoad = [](const ComponentLoad& load) {
+         if (load.reader.Failed() || load.reader.pos != load.reader.size) {
+            WARN("Binary data of '{}' is corrupted", load.name);
+         }
+      };
+
+      // jobs only read own block and uuid map of scene, registry is not touched until insert
+      auto& jobSystem = JobSystem::Get();
+      JobCounter decodeCounter;
+
+      for (auto& load : loads) {
+         jobSystem.Run("Decode component block", [&, &load = load] {
+            // exception must not leave worker, it fails the load after wait
+            try {
+               const auto& ti = typer.GetTypeInfoByIndex(typer.components[load.componentIdx].typeIndex);
+               u32 nComponents = (u32)load.entities.size();
+
+               if (ti.podBinaryOp) {
+                  const auto& op = *ti.podBinaryOp;
+                  if (nComponents > 0 && op.offset == 0 && op.size == (u32)ti.typeSizeOf) {
+                     // binary form is whole component, block is copied to staging at once
+                     load.reader.ReadBytes(load.staging->At(0), (size_t)nComponents * op.size);
+                  } else if (const u8* src = load.reader.SkipArray(nComponents, op.size)) {
+                     for (u32 i = 0; i < nComponents; ++i) {
+                        memcpy(load.staging->At(i) + op.offset, src + (size_t)i * op.size, op.size);
+                     }
+                  }
+               } else {
+                  for (u32 i = 0; i < nComponents; ++i) {
+                     typer.DeserializeBin(load.reader, ti, load.staging->At(i));
+                  }
+               }
+               checkLoad(load);
+            } catch (const std::exception& e) {
+               WARN("Failed to decode '{}': {}", load.name, e.what());
+               load.failed = true;
+            }
+         }, &decodeCounter);
+      }
+
+      // hierarchy is restored on this thread while components are decoded
+      if (transformLoad) {
+         PROFILE_CPU("Transforms");
+
+         const auto& ti = typer.GetTypeInfo<SceneTransformComponent>();
+         for (auto entityID : transformLoad->entities) {
+            Entity entity{ entityID, scene.get() };
+            typer.DeserializeBin(transformLoad->reader, ti, (u8*)&entity.GetTransform());
+         }
+         checkLoad(*transformLoad);
+      }
+
+      {
+         PROFILE_CPU("Wait components decode");
+         jobSystem.Wait(decodeCounter);
+      }
+
+      if (std::ranges::any_of(loads, &ComponentLoad::failed)) {
+         WARN("Binary scene '{}' failed to load", path);
+         Scene::SetCurrentDeserializedScene(nullptr);
+         return {};
+      }
+
+      {
+         PROFILE_CPU("Insert components");
+
+         for (auto& load : loads) {
+            load.staging->Insert(*scene, load.entities);
+         }
+      }
+
+      {
+         PROFILE_CPU("Enable");
+
+         for (u32 i = 0; i < nEntities; ++i) {
+            if (!(flags[i] & EntityDisabled)) {
+               scene->EntityEnable(entities[i].GetEntityID(), true, false);
+            }
+         }
+
+         scene->OnDeserialized();
+      }
+
+      Scene::SetCurrentDeserializedScene(nullptr);
+
+      return scene;
+   }
+
+}
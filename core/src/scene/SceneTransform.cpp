@@ -8,6 +8,7 @@
 #include "gui/Gui.h"
 #include "math/Common.h"
 #include "math/Random.h"
+#include "typer/BinarySerialize.h"
 #include "typer/Registration.h"
 #include "typer/Serialize.h"
 #include "physics/PhysXTypeConvet.h"
@@ -76,10 +77,16 @@ namespace pbe {
    }
 
    Transform& SceneTransformComponent::Local() {
+      MarkWorldDirty();
       return local;
    }
 
    Transform SceneTransformComponent::World() const {
+      if (!worldDirty) {
+         return world;
+      }
+
+      // not cached here, getters may be called from several threads
       Transform transform = local;
       if (parent) {
          auto& pTrans = parent.Get<SceneTransformComponent>();
@@ -92,39 +99,21 @@ namespace pbe {
       if (space == Space::Local) {
          return local.position;
       }
-
-      vec3 pos = local.position;
-      if (parent) {
-         auto& pTrans = parent.Get<SceneTransformComponent>();
-         pos = pTrans.Position() + pTrans.Rotation() * (pos * pTrans.Scale());
-      }
-      return pos;
+      return World().position;
    }
 
    quat SceneTransformComponent::Rotation(Space space) const {
       if (space == Space::Local) {
          return local.rotation;
       }
-
-      quat rot = local.rotation;
-      if (parent) {
-         auto& pTrans = parent.Get<SceneTransformComponent>();
-         rot = pTrans.Rotation() * rot;
-      }
-      return rot;
+      return World().rotation;
    }
 
    vec3 SceneTransformComponent::Scale(Space space) const {
       if (space == Space::Local) {
          return local.scale;
       }
-
-      vec3 s = local.scale;
-      if (parent) {
-         auto& pTrans = parent.Get<SceneTransformComponent>();
-         s *= pTrans.Scale();
-      }
-      return s;
+      return World().scale;
    }
 
    SceneTransformComponent& SceneTransformComponent::SetTransform(const Transform& transform, Space space) {
@@ -134,6 +123,7 @@ namespace pbe {
       } else {
          local = transform;
       }
+      MarkWorldDirty();
       return *this;
    }
 
@@ -144,6 +134,7 @@ namespace pbe {
       } else {
          local.position = pos;
       }
+      MarkWorldDirty();
       return *this;
    }
 
@@ -154,6 +145,7 @@ namespace pbe {
       } else {
          local.rotation = rot;
       }
+      MarkWorldDirty();
       return *this;
    }
 
@@ -164,6 +156,7 @@ namespace pbe {
       } else {
          local.scale = s;
       }
+      MarkWorldDirty();
       return *this;
    }
 
@@ -204,6 +197,9 @@ namespace pbe {
 
    SceneTransformComponent::SceneTransformComponent(Entity entity, Entity parent)
       : entity(entity) {
+      // created dirty
+      entity.GetScene()->dirtyTransformRoots.push_back(entity.GetEntityID());
+
       if (parent) {
          SetParent(parent);
       }
@@ -222,6 +218,27 @@ namespace pbe {
       prevWorld = World();
    }
 
+   void SceneTransformComponent::MarkWorldDirty() {
+      if (worldDirty) {
+         return;
+      }
+      MarkSubtreeDirty();
+
+      // scene updates only subtrees of tracked entities
+      entity.GetScene()->dirtyTransformRoots.push_back(entity.GetEntityID());
+   }
+
+   void SceneTransformComponent::MarkSubtreeDirty() {
+      worldDirty = true;
+
+      for (auto child : children) {
+         auto& childTrans = child.Get<SceneTransformComponent>();
+         if (!childTrans.worldDirty) {
+            childTrans.MarkSubtreeDirty();
+         }
+      }
+   }
+
    SceneTransformComponent& SceneTransformComponent::AddChild(Entity child, int iChild, bool keepLocalTransform) {
       child.Get<SceneTransformComponent>().SetParent(entity, iChild, keepLocalTransform);
       return *this;
@@ -286,8 +303,13 @@ namespace pbe {
          SetPosition(pos);
          SetRotation(rot);
          SetScale(scale);
+      } else {
+         MarkWorldDirty();
       }
 
+      // entity may have been dirty only through old ancestor, whose update does not reach it anymore
+      entity.GetScene()->dirtyTransformRoots.push_back(entity.GetEntityID());
+
       return *this;
    }
 
@@ -329,6 +351,7 @@ namespace pbe {
       success &= deser.Deser("position", local.position);
       success &= deser.Deser("rotation", local.rotation);
       success &= deser.Deser("scale", local.scale);
+      MarkWorldDirty();
 
       // note: we will be added by our parent
       // auto parent = deser.Deser<u64>("parent");
@@ -345,6 +368,39 @@ namespace pbe {
       return success;
    }
 
+   void SceneTransformComponent::SerializeBin(BinaryWriter& writer) const {
+      writer.Write(local.position);
+      writer.Write(local.rotation);
+      writer.Write(local.scale);
+
+      writer.Write((u32)children.size());
+      for (auto child : children) {
+         writer.Write((u64)child.GetUUID());
+      }
+   }
+
+   bool SceneTransformComponent::DeserializeBin(BinaryReader& reader) {
+      RemoveAllChild();
+
+      local.position = reader.Read<vec3>();
+      local.rotation = reader.Read<quat>();
+      local.scale = reader.Read<vec3>();
+      MarkWorldDirty();
+
+      u32 nChildren = reader.Read<u32>();
+      if (!reader.Has(nChildren * sizeof(u64))) {
+         return false;
+      }
+
+      children.reserve(nChildren);
+      for (u32 i = 0; i < nChildren; ++i) {
+         u64 childUuid = reader.Read<u64>();
+         AddChild(entity.GetScene()->GetEntity(childUuid), -1, true);
+      }
+
+      return !reader.Failed();
+   }
+
    bool SceneTransformComponent::UI() {
       bool editted = false;
 
@@ -358,6 +414,10 @@ namespace pbe {
 
       editted |= Vec3UI("Scale", local.scale, 1, 70);
 
+      if (editted) {
+         MarkWorldDirty();
+      }
+
       return editted;
    }
 
@@ -7,6 +7,9 @@
 
 namespace pbe {
 
+   struct BinaryWriter;
+   struct BinaryReader;
+
    struct TransformChangedMarker {};
 
    struct CORE_API SceneTransformComponent {
@@ -18,7 +21,9 @@ namespace pbe {
       std::vector<Entity> children;
 
       const Transform& Local() const;
+      // marks world transform dirty, caller is expected to modify it
       Transform& Local();
+      // cached after Scene::UpdateWorldTransforms, computed from parents while dirty
       Transform World() const;
 
       vec3 Position(Space space = Space::World) const;
@@ -57,18 +62,32 @@ namespace pbe {
 
       void Serialize(Serializer& ser) const;
       bool Deserialize(const Deserializer& deser);
+      void SerializeBin(BinaryWriter& writer) const;
+      bool DeserializeBin(BinaryReader& reader);
       bool UI();
 
       auto begin() { return children.begin(); }
       auto end() { return children.end(); }
 
+      // world transform of this entity and all its children must be recomputed
+      void MarkWorldDirty();
+      bool IsWorldDirty() const { return worldDirty; }
+
    private:
+      friend class Scene;
+
+      void MarkSubtreeDirty();
+
       Transform local{
          .position = vec3_Zero,
          .rotation = quat_Identity,
          .scale = vec3_One,
       };
 
+      // if entity is dirty all its children are dirty too
+      Transform world;
+      bool worldDirty = true;
+
       // todo:
       Transform prevWorld{
          .position = vec3_Zero,
@@ -40,7 +40,7 @@ namespace pbe {
       return SceneHier::FindParentWithComponent<RigidBodyComponent>(entity) == NullEntity;
    }
 
-   static Entity CreateEmpty(Scene& scene, string_view namePrefix, Entity parent, const vec3& pos, Space space) {
+   Entity CreateEmpty(Scene& scene, string_view namePrefix, Entity parent, const vec3& pos, Space space) {
       // todo: find appropriate name
       auto entity = scene.Create(namePrefix);
 
@@ -252,25 +252,32 @@ namespace pbe {
       // std::vector<WaterWaveDesc> wavesDesc = GenerateWavesDesc2();
 
       std::vector<WaveData> waves;
+      std::vector<float> rnd;
 
       for (const auto& waveDesc : wavesDesc) {
          if (waveDesc.weight < EPSILON) {
             continue;
          }
 
+         // length, direction angle, amplitude, phase
+         rnd.resize(waveDesc.nWaves * 4);
+         Random::Generator().Fill(rnd);
+
          for (int i = 0; i < waveDesc.nWaves; ++i) {
             const float g = 9.8f;
+            const float* r = &rnd[i * 4];
 
             WaveData wave;
 
-            float wavelength = Random::Float(waveDesc.lengthMin, waveDesc.lengthMax);
-            wave.direction = glm::normalize(Random::UniformInCircle()); // todo:
-            wave.amplitude = Random::Float(waveDesc.amplitudeMin, waveDesc.amplitudeMax) * waveDesc.weight;
+            float wavelength = glm::mix(waveDesc.lengthMin, waveDesc.lengthMax, r[0]);
+            float angle = r[1] * PI2;
+            wave.direction = { std::cos(angle), std::sin(angle) };
+            wave.amplitude = glm::mix(waveDesc.amplitudeMin, waveDesc.amplitudeMax, r[2]) * waveDesc.weight;
             wave.length = wavelength; // todo:
 
             wave.magnitude = PI2 / wavelength;
             wave.frequency = sqrt((g * PI2) / wavelength);
-            wave.phase = Random::Float(0.f, PI2);
+            wave.phase = r[3] * PI2;
             wave.steepness = waveDesc.steepness;
 
             waves.emplace_back(wave);
@@ -5,26 +5,40 @@
 #include "math/Types.h"
 #include "scene/Component.h"
 #include "scene/Entity.h"
+#include "typer/BinarySerialize.h"
 #include "typer/Serialize.h"
 
 
 namespace pbe {
 
-   static void SerVec3(Serializer& ser, const vec3& v) {
-      ser.out << YAML::Flow << YAML::BeginSeq << v.x << v.y << v.z << YAML::EndSeq;
+   void ValueSerializer<Entity>::Serialize(Serializer& ser, const Entity& value) {
+      ser.out << (value.Valid() ? (u64)value.GetUUID() : (u64)entt::null);
    }
 
-   static bool DeserVec3(const Deserializer& deser, vec3& v) {
-      if (!deser.node.IsSequence() || deser.node.size() != 3) {
-         return false;
+   bool ValueSerializer<Entity>::Deserialize(const Deserializer& deser, Entity& value) {
+      UUID entityUUID = deser.node.as<u64>();
+      if ((u64)entityUUID != (u64)entt::null) {
+         Scene* scene = Scene::GetCurrentDeserializedScene();
+         value = scene->GetEntity(entityUUID);
       }
 
-      v.x = deser.node[0].as<float>();
-      v.y = deser.node[1].as<float>();
-      v.z = deser.node[2].as<float>();
       return true;
    }
 
+   void ValueSerializer<Entity>::SerializeBin(BinaryWriter& writer, const Entity& value) {
+      writer.Write(value.Valid() ? (u64)value.GetUUID() : (u64)entt::null);
+   }
+
+   bool ValueSerializer<Entity>::DeserializeBin(BinaryReader& reader, Entity& value) {
+      UUID entityUUID = reader.Read<u64>();
+      if ((u64)entityUUID != (u64)entt::null) {
+         Scene* scene = Scene::GetCurrentDeserializedScene();
+         value = scene->GetEntity(entityUUID);
+      }
+
+      return !reader.Failed();
+   }
+
 #define START_DECL_TYPE(Type) \
    ti = {}; \
    ti.name = STRINGIFY(Type); \
@@ -32,8 +46,12 @@ namespace pbe {
    ti.typeSizeOf = sizeof(Type)
 
 #define DEFAULT_SER_DESER(Type) \
-   ti.serialize = [](Serializer& ser, const u8* value) { ser.out << *(Type*)value; }; \
-   ti.deserialize = [](const Deserializer& deser, u8* value) { return YAML::convert<Type>::decode(deser.node, *(Type*)value); };
+   ti.serialize = [](Serializer& ser, const u8* value) { ValueSerializer<Type>::Serialize(ser, *(const Type*)value); }; \
+   ti.deserialize = [](const Deserializer& deser, u8* value) { return ValueSerializer<Type>::Deserialize(deser, *(Type*)value); };
+
+#define DEFAULT_SER_DESER_BIN(Type) \
+   ti.serializeBin = [](BinaryWriter& writer, const u8* value) { ValueSerializer<Type>::SerializeBin(writer, *(const Type*)value); }; \
+   ti.deserializeBin = [](BinaryReader& reader, u8* value) { return ValueSerializer<Type>::DeserializeBin(reader, *(Type*)value); };
 
 #define END_DECL_TYPE() \
    typer.RegisterType(ti.typeID, std::move(ti))
@@ -44,16 +62,19 @@ namespace pbe {
       START_DECL_TYPE(bool);
       ti.ui = [](const char* name, u8* value) { return ImGui::Checkbox(name, (bool*)value); };
       DEFAULT_SER_DESER(bool);
+      ti.isPod = true;
       END_DECL_TYPE();
 
       START_DECL_TYPE(float);
       ti.ui = [](const char* name, u8* value) { return ImGui::InputFloat(name, (float*)value); };
       DEFAULT_SER_DESER(float);
+      ti.isPod = true;
       END_DECL_TYPE();
 
       START_DECL_TYPE(int);
       ti.ui = [](const char* name, u8* value) { return ImGui::InputInt(name, (int*)value); };
       DEFAULT_SER_DESER(int);
+      ti.isPod = true;
       END_DECL_TYPE();
 
       START_DECL_TYPE(i64);
@@ -64,6 +85,7 @@ namespace pbe {
          // ImGui::InputInt(name, (int*)value);
       };
       DEFAULT_SER_DESER(i64);
+      ti.isPod = true;
       END_DECL_TYPE();
 
       START_DECL_TYPE(u64);
@@ -72,60 +94,32 @@ namespace pbe {
          return ImGui::InputScalar(name, ImGuiDataType_U64, value, NULL, NULL, format, 0);
       };
       DEFAULT_SER_DESER(u64);
+      ti.isPod = true;
       END_DECL_TYPE();
 
       START_DECL_TYPE(string);
       // todo:
       ti.ui = [](const char* name, u8* value) { ImGui::Text(((string*)value)->data()); return false; };
       DEFAULT_SER_DESER(string);
+      DEFAULT_SER_DESER_BIN(string);
       END_DECL_TYPE();
 
       START_DECL_TYPE(vec2);
       ti.ui = [](const char* name, u8* value) { return ImGui::InputFloat2(name, (float*)value); };
-      ti.serialize = [](Serializer& ser, const u8* value){
-         const auto& v = *(vec2*)value;
-         ser.out << YAML::Flow << YAML::BeginSeq << v.x << v.y << YAML::EndSeq;
-      };
-      ti.deserialize = [](const Deserializer& deser, u8* value) {
-         if (!deser.node.IsSequence() || deser.node.size() != 2) {
-            return false;
-         }
-
-         auto& v = *(vec2*)value;
-         v.x = deser.node[0].as<float>();
-         v.y = deser.node[1].as<float>();
-         return true;
-      };
+      DEFAULT_SER_DESER(vec2);
+      ti.isPod = true;
       END_DECL_TYPE();
 
       START_DECL_TYPE(vec3);
       ti.ui = [](const char* name, u8* value) { return ImGui::InputFloat3(name, (float*)value); };
-      ti.serialize = [](Serializer& ser, const u8* value) {
-         SerVec3(ser, *(vec3*)value);
-      };
-      ti.deserialize = [](const Deserializer& deser, u8* value) {
-         return DeserVec3(deser, *(vec3*)value);
-      };
+      DEFAULT_SER_DESER(vec3);
+      ti.isPod = true;
       END_DECL_TYPE();
 
       START_DECL_TYPE(vec4);
       ti.ui = [](const char* name, u8* value) { return ImGui::ColorEdit4(name, (float*)value); };
-      ti.serialize = [](Serializer& ser, const u8* value) {
-         const auto& v = *(vec4*)value;
-         ser.out << YAML::Flow << YAML::BeginSeq << v.x << v.y << v.z << v.w << YAML::EndSeq;
-      };
-      ti.deserialize = [](const Deserializer& deser, u8* value) {
-         if (!deser.node.IsSequence() || deser.node.size() != 4) {
-            return false;
-         }
-
-         auto& v = *(vec4*)value;
-         v.x = deser.node[0].as<float>();
-         v.y = deser.node[1].as<float>();
-         v.z = deser.node[2].as<float>();
-         v.w = deser.node[3].as<float>();
-         return true;
-      };
+      DEFAULT_SER_DESER(vec4);
+      ti.isPod = true;
       END_DECL_TYPE();
 
       START_DECL_TYPE(quat);
@@ -137,18 +131,8 @@ namespace pbe {
          }
          return false;
       };
-      ti.serialize = [](Serializer& ser, const u8* value) {
-         auto angles = glm::degrees(glm::eulerAngles(*(quat*)value));
-         SerVec3(ser, angles);
-      };
-      ti.deserialize = [](const Deserializer& deser, u8* value) {
-         vec3 angles;
-         if (!DeserVec3(deser, angles)) {
-            return false;
-         }
-         *(quat*)value = glm::quat{ glm::radians(angles) };
-         return true;
-      };
+      DEFAULT_SER_DESER(quat);
+      ti.isPod = true;
       END_DECL_TYPE();
 
       // todo: it is not basic type
@@ -171,24 +155,8 @@ namespace pbe {
 
          return false;
       };
-      ti.serialize = [](Serializer& ser, const u8* value) {
-         const auto& e = *(Entity*)value;
-
-         if (e.Valid()) {
-            ser.out << (pbe::u64)e.GetUUID();
-         } else {
-            ser.out << (pbe::u64)entt::null;
-         }
-      };
-      ti.deserialize = [](const Deserializer& deser, u8* value) {
-         pbe::UUID entityUUID = deser.node.as<pbe::u64>();
-         if ((pbe::u64)entityUUID != (pbe::u64)entt::null) {
-            pbe::Scene* scene = pbe::Scene::GetCurrentDeserializedScene();
-            *(Entity*)value = scene->GetEntity(entityUUID);
-         }
-
-         return true;
-      };
+      DEFAULT_SER_DESER(Entity);
+      DEFAULT_SER_DESER_BIN(Entity);
       END_DECL_TYPE();
    }
 
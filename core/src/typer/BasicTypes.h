@@ -1,9 +1,131 @@
 #pragma once
 
+#include "BinarySerialize.h"
+#include "Serialize.h"
+#include "core/Core.h"
+#include "math/Types.h"
+
 namespace pbe {
 
    class Typer;
+   class Entity;
 
    void RegisterBasicTypes(Typer& typer);
 
+   // serialization of type known at compile time. Basic types are registered with it
+   // and struct fields of these types call it directly, other fields go through Typer
+   template<typename T>
+   struct ValueSerializer {};
+
+   template<typename T>
+   concept HasValueSerializer = requires(Serializer& ser, const Deserializer& deser, T& value) {
+      ValueSerializer<T>::Serialize(ser, value);
+      { ValueSerializer<T>::Deserialize(deser, value) } -> std::same_as<bool>;
+   };
+
+   // binary form of type that is not copied as bytes
+   template<typename T>
+   concept HasValueSerializerBin = requires(BinaryWriter& writer, BinaryReader& reader, T& value) {
+      ValueSerializer<T>::SerializeBin(writer, value);
+      { ValueSerializer<T>::DeserializeBin(reader, value) } -> std::same_as<bool>;
+   };
+
+   template<typename T>
+   struct YamlScalarSerializer {
+      static void Serialize(Serializer& ser, const T& value) {
+         ser.out << value;
+      }
+
+      static bool Deserialize(const Deserializer& deser, T& value) {
+         return YAML::convert<T>::decode(deser.node, value);
+      }
+   };
+
+   template<> struct ValueSerializer<bool> : YamlScalarSerializer<bool> {};
+   template<> struct ValueSerializer<float> : YamlScalarSerializer<float> {};
+   template<> struct ValueSerializer<int> : YamlScalarSerializer<int> {};
+   template<> struct ValueSerializer<i64> : YamlScalarSerializer<i64> {};
+   template<> struct ValueSerializer<u64> : YamlScalarSerializer<u64> {};
+
+   template<>
+   struct ValueSerializer<string> : YamlScalarSerializer<string> {
+      static void SerializeBin(BinaryWriter& writer, const string& value) {
+         writer.WriteString(value);
+      }
+
+      static bool DeserializeBin(BinaryReader& reader, string& value) {
+         value = reader.ReadString();
+         return !reader.Failed();
+      }
+   };
+
+   // vectors are flow sequence of components
+   template<int N>
+   struct VecSerializer {
+      using Vec = glm::vec<N, float, glm::defaultp>;
+
+      static void Serialize(Serializer& ser, const Vec& v) {
+         ser.out << YAML::Flow << YAML::BeginSeq;
+         for (int i = 0; i < N; ++i) {
+            ser.out << v[i];
+         }
+         ser.out << YAML::EndSeq;
+      }
+
+      static bool Deserialize(const Deserializer& deser, Vec& v) {
+         if (!deser.node.IsSequence() || deser.node.size() != N) {
+            return false;
+         }
+
+         for (int i = 0; i < N; ++i) {
+            v[i] = deser.node[i].template as<float>();
+         }
+         return true;
+      }
+   };
+
+   template<> struct ValueSerializer<vec2> : VecSerializer<2> {};
+   template<> struct ValueSerializer<vec3> : VecSerializer<3> {};
+   template<> struct ValueSerializer<vec4> : VecSerializer<4> {};
+
+   // euler angles in degrees
+   template<>
+   struct ValueSerializer<quat> {
+      static void Serialize(Serializer& ser, const quat& value) {
+         ValueSerializer<vec3>::Serialize(ser, glm::degrees(glm::eulerAngles(value)));
+      }
+
+      static bool Deserialize(const Deserializer& deser, quat& value) {
+         vec3 angles;
+         if (!ValueSerializer<vec3>::Deserialize(deser, angles)) {
+            return false;
+         }
+         value = quat{ glm::radians(angles) };
+         return true;
+      }
+   };
+
+   // uuid, entity is looked up in scene being deserialized
+   template<>
+   struct CORE_API ValueSerializer<Entity> {
+      static void Serialize(Serializer& ser, const Entity& value);
+      static bool Deserialize(const Deserializer& deser, Entity& value);
+
+      static void SerializeBin(BinaryWriter& writer, const Entity& value);
+      static bool DeserializeBin(BinaryReader& reader, Entity& value);
+   };
+
+   // enums are stored as int
+   template<typename T> requires std::is_enum_v<T>
+   struct ValueSerializer<T> {
+      static void Serialize(Serializer& ser, const T& value) {
+         ser.out << (int)value;
+      }
+
+      static bool Deserialize(const Deserializer& deser, T& value) {
+         value = (T)deser.node.as<int>();
+         return true;
+      }
+   };
+
 }
@@ -0,0 +1,14 @@
+#include "pch.h"
+#include "BinarySerialize.h"
+
+namespace pbe {
+
+   u32 BinaryWriter::AddString(std::string_view str) {
+      auto [it, inserted] = stringIndices.try_emplace(std::string{ str }, (u32)strings.size());
+      if (inserted) {
+         strings.emplace_back(it->first);
+      }
+      return it->second;
+   }
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstring>
+
+#include "core/Core.h"
+
+namespace pbe {
+
+   // little endian blob, strings are stored once in table and referenced by index
+   struct CORE_API BinaryWriter {
+      template<typename T> requires std::is_trivially_copyable_v<T>
+      void Write(const T& value) {
+         WriteBytes(&value, sizeof(T));
+      }
+
+      void WriteBytes(const void* data, size_t size) {
+         auto* bytes = (const u8*)data;
+         buffer.insert(buffer.end(), bytes, bytes + size);
+      }
+
+      void WriteString(std::string_view str) {
+         Write(AddString(str));
+      }
+
+      u32 AddString(std::string_view str);
+
+      std::vector<u8> buffer;
+
+      std::vector<std::string_view> strings; // views to stringIndices keys
+      std::unordered_map<std::string, u32> stringIndices;
+   };
+
+   // reads from memory owned by caller (e.g. mapped file), strings are views into it
+   struct BinaryReader {
+      BinaryReader() = default;
+      BinaryReader(const u8* data, size_t size) : data(data), size(size) {}
+
+      template<typename T> requires std::is_trivially_copyable_v<T>
+      T Read() {
+         T value{};
+         ReadBytes(&value, sizeof(T));
+         return value;
+      }
+
+      bool ReadBytes(void* dst, size_t nBytes) {
+         if (!Has(nBytes)) {
+            failed = true;
+            return false;
+         }
+         memcpy(dst, data + pos, nBytes);
+         pos += nBytes;
+         return true;
+      }
+
+      // pointer to next nBytes, nullptr if out of data
+      const u8* Skip(size_t nBytes) {
+         if (!Has(nBytes)) {
+            failed = true;
+            return nullptr;
+         }
+         const u8* ptr = data + pos;
+         pos += nBytes;
+         return ptr;
+      }
+
+      // count is usually read from file, checked without multiplication overflow
+      const u8* SkipArray(u64 count, size_t elemSize) {
+         if (!Has(0) || count > (size - pos) / elemSize) {
+            failed = true;
+            return nullptr;
+         }
+         return Skip(count * elemSize);
+      }
+
+      std::string_view ReadString() {
+         return GetString(Read<u32>());
+      }
+
+      std::string_view GetString(u32 idx) {
+         if (idx >= nStrings) {
+            failed = true;
+            return {};
+         }
+         u32 begin = stringOffsets[idx];
+         u32 end = stringOffsets[idx + 1];
+         if (begin > end || end > stringOffsets[nStrings]) {
+            failed = true;
+            return {};
+         }
+         return { stringData + begin, end - begin };
+      }
+
+      bool Has(size_t nBytes) const { return pos <= size && nBytes <= size - pos; }
+      bool Failed() const { return failed; }
+
+      const u8* data = nullptr;
+      size_t size = 0;
+      size_t pos = 0;
+
+      // string table, offsets has nStrings + 1 entries
+      const u32* stringOffsets = nullptr;
+      const char* stringData = nullptr;
+      u32 nStrings = 0;
+
+      bool failed = false;
+   };
+
+}
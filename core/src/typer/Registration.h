@@ -1,6 +1,8 @@
 #pragma once
 
+#include "BasicTypes.h"
 #include "Typer.h"
+#include "scene/ECSScene.h"
 
 
 namespace pbe {
@@ -15,6 +17,16 @@ namespace pbe {
       { a.Deserialize(deser) } -> std::same_as<bool>;
    };
 
+   template<typename T>
+   concept HasSerializeBin = requires(T a, BinaryWriter & writer) {
+      { a.SerializeBin(writer) };
+   };
+
+   template<typename T>
+   concept HasDeserializeBin = requires(T a, BinaryReader & reader) {
+      { a.DeserializeBin(reader) } -> std::same_as<bool>;
+   };
+
    template<typename T>
    concept HasUI = requires(T a) {
       { a.UI() } -> std::same_as<bool>;
@@ -53,6 +65,24 @@ namespace pbe {
       }
    }
 
+   template<typename T>
+   auto GetSerializeBin() {
+      if constexpr (HasSerializeBin<T>) {
+         return [](BinaryWriter& writer, const u8* data) { ((T*)data)->SerializeBin(writer); };
+      } else {
+         return nullptr;
+      }
+   }
+
+   template<typename T>
+   auto GetDeserializeBin() {
+      if constexpr (HasDeserializeBin<T>) {
+         return [](BinaryReader& reader, u8* data) -> bool { return ((T*)data)->DeserializeBin(reader); };
+      } else {
+         return nullptr;
+      }
+   }
+
    template<typename T>
    auto GetUI() {
       if constexpr (HasUI<T>) {
@@ -89,6 +119,34 @@ namespace pbe {
       }
    }
 
+   template<typename Component>
+   struct ComponentStagingT : ComponentStaging {
+      ComponentStagingT(u32 count) : components(count) {}
+
+      u8* At(u32 idx) override {
+         return (u8*)&components[idx];
+      }
+
+      void Insert(ECSScene& scene, std::span<const entt::entity> entities) override {
+         ASSERT(entities.size() == components.size());
+         scene.InsertComponents<Component>(entities.begin(), entities.end(), components.begin());
+      }
+
+      std::vector<Component> components;
+   };
+
+   template<typename T>
+   void SetFieldSerializers(TypeField& f) {
+      if constexpr (HasValueSerializer<T>) {
+         f.serialize = [](Serializer& ser, const u8* value) { ValueSerializer<T>::Serialize(ser, *(const T*)value); };
+         f.deserialize = [](const Deserializer& deser, u8* value) { return ValueSerializer<T>::Deserialize(deser, *(T*)value); };
+      }
+      if constexpr (HasValueSerializerBin<T>) {
+         f.serializeBin = [](BinaryWriter& writer, const u8* value) { ValueSerializer<T>::SerializeBin(writer, *(const T*)value); };
+         f.deserializeBin = [](BinaryReader& reader, u8* value) { return ValueSerializer<T>::DeserializeBin(reader, *(T*)value); };
+      }
+   }
+
 #define TYPE_REGISTER_GUARD_UNIQUE(unique) \
    static TypeRegisterGuard CONCAT(TypeRegisterGuard_, unique)
 
@@ -114,6 +172,8 @@ namespace pbe {
    TYPE_BEGIN(type) \
       ti.serialize = GetSerialize<type>(); \
       ti.deserialize = GetDeserialize<type>(); \
+      ti.serializeBin = GetSerializeBin<type>(); \
+      ti.deserializeBin = GetDeserializeBin<type>(); \
       ti.ui = GetUI<type>(); \
       \
       TypeField f{};
@@ -135,6 +195,7 @@ namespace pbe {
       f.name = #_name; \
       f.typeID = GetTypeID<decltype(CurrentType{}._name)>(); \
       f.offset = offsetof(CurrentType, _name); \
+      SetFieldSerializers<decltype(CurrentType{}._name)>(f); \
       ti.fields.emplace_back(f); \
       f = {};
 
@@ -152,9 +213,10 @@ namespace pbe {
       enumDescCombo += '\0';
 
 #define ENUM_END() \
-      ti.serialize = [](Serializer& ser, const u8* value) { ser.out << *(int*)value; }; \
-      ti.deserialize = [](const Deserializer& deser, u8* value) { *(int*)value = deser.node.as<int>(); return true; }; \
+      ti.serialize = [](Serializer& ser, const u8* value) { ValueSerializer<CurrentType>::Serialize(ser, *(const CurrentType*)value); }; \
+      ti.deserialize = [](const Deserializer& deser, u8* value) { return ValueSerializer<CurrentType>::Deserialize(deser, *(CurrentType*)value); }; \
       ti.ui = [](const char* name, u8* value) { return ImGui::Combo(name, (int*)value, enumDescCombo.c_str()); }; \
+      ti.isPod = true; \
       Typer::Get().RegisterType(ti.typeID, std::move(ti)); \
    }};
 
@@ -174,6 +236,8 @@ namespace pbe {
       ComponentInfo ci{}; \
       ci.typeID = GetTypeID<Component>(); \
       \
+      ci.createStaging = [](u32 count) -> Own<ComponentStaging> { return std::make_unique<ComponentStagingT<Component>>(count); }; \
+      \
       ci.copyCtor = [](Entity& dst, const void* src) { auto srcCompPtr = (Component*)src; return (void*)&dst.Add<Component>((Component&)*srcCompPtr); }; \
       ci.moveCtor = [](Entity& dst, const void* src) { auto srcCompPtr = (Component*)src; return (void*)&dst.Add<Component>((Component&&)*srcCompPtr); }; \
       \
@@ -30,6 +30,16 @@ namespace pbe {
       return Typer::Get().Deserialize((*this), name, typeID, value);
    }
 
+   Deserializer Deserializer::Clone() const {
+      return Deserializer{ YAML::Clone(node) };
+   }
+
+   void Deserializer::ForEach(const std::function<void(std::string_view key, const Deserializer& value)>& func) const {
+      for (auto it : node) {
+         func(it.first.Scalar(), Deserializer{ it.second });
+      }
+   }
+
    Deserializer::Deserializer(YAML::Node node) : node(std::move(node)) {
    }
 }
@@ -20,8 +20,8 @@ namespace pbe {
 
       void Ser(std::string_view name, TypeID typeID, const u8* value);
 
-      template<typename Key>
-      void Key(const Key& key) {
+      template<typename T>
+      void Key(const T& key) {
          out << YAML::Key << key << YAML::Value;
       }
 
@@ -65,6 +65,12 @@ namespace pbe {
 
       std::size_t Size() const { return node.size(); }
 
+      // deep copy in own node memory, may be read on other thread while original document is used
+      Deserializer Clone() const;
+
+      // map node, entries in file order
+      void ForEach(const std::function<void(std::string_view key, const Deserializer& value)>& func) const;
+
       template <typename Key>
       const Deserializer operator[](const Key& key) const {
          return node[key];
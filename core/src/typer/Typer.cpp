@@ -1,11 +1,14 @@
 #include "pch.h"
 #include "Typer.h"
 #include "BasicTypes.h"
+#include "BinarySerialize.h"
 #include "Serialize.h"
 #include "core/Assert.h"
+#include "core/MemoryTracker.h"
 #include "fs/FileSystem.h"
 #include "gui/Gui.h"
 #include "scene/Component.h"
+#include "utils/Hash.h"
 
 namespace pbe {
 
@@ -46,26 +49,33 @@ namespace pbe {
    }
 
    void Typer::RegisterType(TypeID typeID, TypeInfo&& ti) {
+      MEMORY_TAG(Typer);
       ASSERT(types.find(typeID) == types.end());
       types[typeID] = std::move(ti);
+      InvalidateTables();
    }
 
    void Typer::UnregisterType(TypeID typeID) {
+      InvalidateTables();
       types.erase(typeID);
    }
 
    void Typer::RegisterComponent(ComponentInfo&& ci) {
+      MEMORY_TAG(Typer);
       auto it = std::ranges::find(components, ci.typeID, &ComponentInfo::typeID);
       ASSERT(it == components.end());
       components.emplace_back(std::forward<ComponentInfo>(ci));
+      InvalidateTables();
    }
 
    void Typer::UnregisterComponent(TypeID typeID) {
       auto it = std::ranges::find(components, typeID, &ComponentInfo::typeID);
       components.erase(it);
+      InvalidateTables();
    }
 
    void Typer::RegisterScript(ScriptInfo&& si) {
+      MEMORY_TAG(Typer);
       auto it = std::ranges::find(scripts, si.typeID, &ScriptInfo::typeID);
       ASSERT(it == scripts.end());
       scripts.emplace_back(std::move(si));
@@ -84,9 +94,31 @@ namespace pbe {
       return types.at(typeID);
    }
 
+   const ComponentInfo* Typer::FindComponent(std::string_view name) const {
+      ASSERT_MESSAGE(finalized, "Typer::Finalize must be called after types registration");
+      auto it = componentIndices.find(name);
+      return it != componentIndices.end() ? &components[it->second] : nullptr;
+   }
+
+   ComponentMask Typer::GetComponentMask(const Entity& entity) const {
+      ASSERT_MESSAGE(finalized, "Typer::Finalize must be called after types registration");
+
+      // only storages that contain entity are looked up, markers and scripts are not in table
+      ComponentMask mask;
+      entity.GetScene()->ForEachStorageOf(entity.GetEntityID(), [&](entt::id_type storageID) {
+         auto it = componentIndicesByStorage.find(storageID);
+         if (it != componentIndicesByStorage.end()) {
+            mask.Set(it->second);
+         }
+      });
+      return mask;
+   }
+
    bool Typer::UI(std::string_view name, TypeID typeID, u8* value) const {
-      const auto& ti = types.at(typeID);
+      return UI(name, types.at(typeID), value);
+   }
 
+   bool Typer::UI(std::string_view name, const TypeInfo& ti, u8* value) const {
       bool edited = false;
 
       if (ti.ui) {
@@ -111,7 +143,7 @@ namespace pbe {
                if (f.ui) {
                   edited |= f.ui(fieldName, data);
                } else {
-                  edited |= UI(fieldName, f.typeID, data);
+                  edited |= UI(fieldName, GetTypeInfo(f.typeID, f.typeIndex), data);
                }
             }
          }
@@ -126,8 +158,10 @@ namespace pbe {
 
    void Typer::Serialize(Serializer& ser, std::string_view name, TypeID typeID, const u8* value) const {
       ASSERT(types.find(typeID) != types.end());
-      const auto& ti = types.at(typeID);
+      Serialize(ser, name, types.at(typeID), value);
+   }
 
+   void Typer::Serialize(Serializer& ser, std::string_view name, const TypeInfo& ti, const u8* value) const {
       if (!name.empty()) {
          ser.out << YAML::Key << name.data() << YAML::Value;
       }
@@ -143,22 +177,45 @@ namespace pbe {
             }
 
             const u8* data = value + f.offset;
-            Serialize(ser, f.Name(), f.typeID, data);
+            if (f.serialize) {
+               const char* fieldName = f.Name();
+               if (*fieldName) {
+                  ser.out << YAML::Key << fieldName << YAML::Value;
+               }
+               f.serialize(ser, data);
+            } else {
+               Serialize(ser, f.Name(), GetTypeInfo(f.typeID, f.typeIndex), data);
+            }
          }
       }
    }
 
-   bool Typer::Deserialize(const Deserializer& deser, std::string_view name, TypeID typeID, u8* value) const {
-      bool hasName = !name.empty();
+   static bool DeserializeField(const Deserializer& deser, const TypeField& f, u8* value) {
+      const char* fieldName = f.Name();
+      if (!*fieldName) {
+         return f.deserialize(deser, value);
+      }
 
-      if (hasName && !deser[name.data()]) {
-         WARN("Serialization failed! Cant find {}", name);
+      auto node = deser[fieldName];
+      if (!node) {
+         WARN("Serialization failed! Cant find {}", fieldName);
          return false;
       }
+      return f.deserialize(node, value);
+   }
 
-      const auto& ti = types.at(typeID);
+   bool Typer::Deserialize(const Deserializer& deser, std::string_view name, TypeID typeID, u8* value) const {
+      return Deserialize(deser, name, types.at(typeID), value);
+   }
+
+   bool Typer::Deserialize(const Deserializer& deser, std::string_view name, const TypeInfo& ti, u8* value) const {
+      bool hasName = !name.empty();
 
       const Deserializer& nodeFields = hasName ? deser[name.data()] : deser;
+      if (hasName && !nodeFields) {
+         WARN("Serialization failed! Cant find {}", name);
+         return false;
+      }
 
       if (ti.deserialize) {
          return ti.deserialize(nodeFields, value);
@@ -172,7 +229,73 @@ namespace pbe {
             // }
 
             u8* data = value + f.offset;
-            success &= Deserialize(nodeFields, f.Name(), f.typeID, data);
+            if (f.deserialize) {
+               success &= DeserializeField(nodeFields, f, data);
+            } else {
+               success &= Deserialize(nodeFields, f.Name(), GetTypeInfo(f.typeID, f.typeIndex), data);
+            }
+         }
+
+         return success;
+      }
+   }
+
+   void Typer::SerializeBin(BinaryWriter& writer, TypeID typeID, const u8* value) const {
+      SerializeBin(writer, types.at(typeID), value);
+   }
+
+   void Typer::SerializeBin(BinaryWriter& writer, const TypeInfo& ti, const u8* value) const {
+      if (ti.serializeBin) {
+         ti.serializeBin(writer, value);
+      } else if (ti.isPod) {
+         writer.WriteBytes(value, ti.typeSizeOf);
+      } else if (ti.serialize) {
+         // no binary form, yaml text is stored in string table
+         Serializer ser;
+         ti.serialize(ser, value);
+         writer.WriteString(ser.Str());
+      } else {
+         ASSERT_MESSAGE(ti.fields.empty() || !ti.binaryOps.empty(), "Typer::Finalize must be called before binary serialization");
+
+         for (const auto& op : ti.binaryOps) {
+            if (op.typeID == InvalidTypeID) {
+               writer.WriteBytes(value + op.offset, op.size);
+            } else if (op.serializeBin) {
+               op.serializeBin(writer, value + op.offset);
+            } else {
+               SerializeBin(writer, GetTypeInfo(op.typeID, op.typeIndex), value + op.offset);
+            }
+         }
+      }
+   }
+
+   bool Typer::DeserializeBin(BinaryReader& reader, TypeID typeID, u8* value) const {
+      return DeserializeBin(reader, types.at(typeID), value);
+   }
+
+   bool Typer::DeserializeBin(BinaryReader& reader, const TypeInfo& ti, u8* value) const {
+      if (ti.deserializeBin) {
+         return ti.deserializeBin(reader, value);
+      } else if (ti.isPod) {
+         return reader.ReadBytes(value, ti.typeSizeOf);
+      } else if (ti.serialize) {
+         auto str = reader.ReadString();
+         if (reader.Failed() || !ti.deserialize) {
+            return false;
+         }
+         auto deser = Deserializer::FromStr(str);
+         return ti.deserialize(deser, value);
+      } else {
+         bool success = true;
+
+         for (const auto& op : ti.binaryOps) {
+            if (op.typeID == InvalidTypeID) {
+               success &= reader.ReadBytes(value + op.offset, op.size);
+            } else if (op.deserializeBin) {
+               success &= op.deserializeBin(reader, value + op.offset);
+            } else {
+               success &= DeserializeBin(reader, GetTypeInfo(op.typeID, op.typeIndex), value + op.offset);
+            }
          }
 
          return success;
@@ -180,12 +303,53 @@ namespace pbe {
    }
 
    void Typer::Finalize() {
+      MEMORY_TAG(Typer);
+
+      // map nodes are stable, pointers are valid until type is unregistered
+      typesByIndex.clear();
+      for (auto& [_, ti] : types) {
+         ti.index = (u32)typesByIndex.size();
+         typesByIndex.push_back(&ti);
+      }
+
+      for (auto* ti : typesByIndex) {
+         for (auto& f : ti->fields) {
+            f.typeIndex = types.at(f.typeID).index;
+         }
+      }
+
+      ASSERT_MESSAGE(components.size() <= ComponentMask::MaxComponents, "Increase ComponentMask::MaxComponents");
+
+      componentIndices.clear();
+      componentIndicesByStorage.clear();
+      for (u32 i = 0; i < (u32)components.size(); ++i) {
+         auto& ci = components[i];
+         ci.index = i;
+         ci.typeIndex = types.at(ci.typeID).index;
+         componentIndices[typesByIndex[ci.typeIndex]->name] = i;
+         componentIndicesByStorage[ci.typeID] = i;
+      }
+
       std::unordered_set<TypeID> processedTypeIDs;
 
       for (auto& entry : types) {
          TypeInfo& ti = entry.second;
          ProcessType(ti, processedTypeIDs);
       }
+
+      finalized = true;
+   }
+
+   void Typer::InvalidateTables() {
+      finalized = false;
+      typesByIndex.clear();
+      componentIndices.clear();
+      componentIndicesByStorage.clear();
+
+      for (auto& ci : components) {
+         ci.index = InvalidTypeIndex;
+         ci.typeIndex = InvalidTypeIndex;
+      }
    }
 
    void Typer::ProcessType(TypeInfo& ti, std::unordered_set<TypeID>& processedTypeIDs) {
@@ -204,12 +368,67 @@ namespace pbe {
 
             if (filedTypeInfo.hasEntityRef) {
                ti.hasEntityRef = true;
-               break;
             }
          }
       }
 
+      BuildBinaryOps(ti);
+
       processedTypeIDs.insert(ti.typeID);
    }
 
+   static bool HasFieldsBinaryForm(const TypeInfo& ti) {
+      return !ti.serializeBin && !ti.isPod && !ti.serialize;
+   }
+
+   void Typer::BuildBinaryOps(TypeInfo& ti) {
+      ti.binaryOps.clear();
+      ti.podBinaryOp.reset();
+
+      Hasher hasher;
+      hasher.Add(std::string_view{ ti.name });
+      hasher.Add(ti.typeSizeOf);
+
+      if (HasFieldsBinaryForm(ti)) {
+         auto addOp = [&](const BinaryOp& op) {
+            if (!ti.binaryOps.empty()) {
+               auto& last = ti.binaryOps.back();
+               bool canMerge = op.typeID == InvalidTypeID && last.typeID == InvalidTypeID;
+               if (canMerge && last.offset + last.size == op.offset) {
+                  last.size += op.size;
+                  return;
+               }
+            }
+            ti.binaryOps.push_back(op);
+         };
+
+         for (const auto& f : ti.fields) {
+            const auto& fieldTi = GetTypeInfo(f.typeID);
+
+            hasher.Add(std::string_view{ f.name });
+            hasher.Add(f.offset);
+            hasher.Add(fieldTi.binarySchemaHash);
+
+            u32 offset = (u32)f.offset;
+            if (fieldTi.isPod) {
+               addOp({ offset, (u32)fieldTi.typeSizeOf });
+            } else if (HasFieldsBinaryForm(fieldTi)) {
+               for (const auto& op : fieldTi.binaryOps) {
+                  addOp({ offset + op.offset, op.size, op.typeID, op.typeIndex, op.serializeBin, op.deserializeBin });
+               }
+            } else {
+               addOp({ offset, 0, f.typeID, fieldTi.index, f.serializeBin, f.deserializeBin });
+            }
+         }
+      }
+
+      if (!ti.serializeBin && ti.isPod) {
+         ti.podBinaryOp = BinaryOp{ .offset = 0, .size = (u32)ti.typeSizeOf };
+      } else if (ti.binaryOps.size() == 1 && ti.binaryOps[0].typeID == InvalidTypeID) {
+         ti.podBinaryOp = ti.binaryOps[0];
+      }
+
+      ti.binarySchemaHash = hasher.Get();
+   }
+
 }
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <bit>
+
+#include "core/Assert.h"
 #include "core/Core.h"
+#include "core/Ref.h"
 #include "core/Type.h"
 
 
@@ -8,9 +12,12 @@ namespace pbe {
 
    struct Serializer;
    struct Deserializer;
+   struct BinaryWriter;
+   struct BinaryReader;
 
    class Entity;
    class Scene;
+   class ECSScene;
 
    enum class FieldFlag {
       None = 0,
@@ -19,9 +26,18 @@ namespace pbe {
 
    DEFINE_ENUM_FLAG_OPERATORS(FieldFlag);
 
+   // dense index of type or component, assigned by Typer::Finalize
+   constexpr u32 InvalidTypeIndex = UINT32_MAX;
+
+   using SerializeFunc = void(*)(Serializer&, const u8*);
+   using DeserializeFunc = bool(*)(const Deserializer&, u8*);
+   using SerializeBinFunc = void(*)(BinaryWriter&, const u8*);
+   using DeserializeBinFunc = bool(*)(BinaryReader&, u8*);
+
    struct TypeField {
       std::string name;
       TypeID typeID;
+      u32 typeIndex = InvalidTypeIndex;
       size_t offset;
       FieldFlag flags = FieldFlag::None;
 
@@ -36,47 +52,118 @@ namespace pbe {
 
       std::function<bool(const char*, u8*)> ui;
       std::function<bool(const u8*)> use;
+
+      // compiled for field type by STRUCT_FIELD, fields without them go through Typer
+      SerializeFunc serialize = nullptr;
+      DeserializeFunc deserialize = nullptr;
+      SerializeBinFunc serializeBin = nullptr;
+      DeserializeBinFunc deserializeBin = nullptr;
+   };
+
+   // step of binary serialization of struct, built from fields by Typer::Finalize
+   struct BinaryOp {
+      u32 offset;
+      u32 size; // bytes copied as is, if typeID is invalid
+      TypeID typeID = InvalidTypeID;
+      u32 typeIndex = InvalidTypeIndex;
+      // field serializers, Typer is used if not set
+      SerializeBinFunc serializeBin = nullptr;
+      DeserializeBinFunc deserializeBin = nullptr;
    };
 
    struct TypeInfo {
       std::string name;
       TypeID typeID;
+      u32 index = InvalidTypeIndex;
       int typeSizeOf;
       bool hasEntityRef = false;
 
+      // binary form is object bytes, e.g. float, vec3, enum
+      bool isPod = false;
+
       std::vector<TypeField> fields;
 
       std::function<bool(const char*, u8*)> ui;
       std::function<void(Serializer&, const u8*)> serialize;
       std::function<bool(const Deserializer&, u8*)> deserialize;
 
+      std::function<void(BinaryWriter&, const u8*)> serializeBin;
+      std::function<bool(BinaryReader&, u8*)> deserializeBin;
+
+      // nested pod fields are flattened, adjacent ones merged into one copy
+      std::vector<BinaryOp> binaryOps;
+      // set if whole binary form is one copy of bytes, arrays of type are copied without Typer
+      std::optional<BinaryOp> podBinaryOp;
+      // changes with binary layout, binary data with other hash can't be read
+      u64 binarySchemaHash = 0;
+
       bool IsSimpleType() const { return fields.empty(); }
    };
 
+   // components constructed outside of registry, e.g. decoded by jobs on scene load,
+   // and moved to entities at once
+   struct ComponentStaging {
+      virtual ~ComponentStaging() = default;
+
+      // components are contiguous, At(i) == At(0) + i * typeSizeOf
+      virtual u8* At(u32 idx) = 0;
+      // entities[i] gets component i, entities must not have component
+      virtual void Insert(ECSScene& scene, std::span<const entt::entity> entities) = 0;
+   };
+
+   // table of functions of component type, filled by INTERNAL_ADD_COMPONENT
    struct ComponentInfo {
       TypeID typeID;
+      u32 index = InvalidTypeIndex; // in Typer::components
+      u32 typeIndex = InvalidTypeIndex;
+
+      // count default constructed components
+      Own<ComponentStaging>(*createStaging)(u32 count) = nullptr;
+
+      void* (*copyCtor)(Entity&, const void*) = nullptr;
+      void* (*moveCtor)(Entity&, const void*) = nullptr;
+
+      bool (*has)(const Entity&) = nullptr;
+      void* (*add)(Entity&) = nullptr;
+      void (*remove)(Entity&) = nullptr;
+      void* (*get)(Entity&) = nullptr; // todo: remove?
 
-      std::function<void* (Entity&, const void*)> copyCtor;
-      std::function<void* (Entity&, const void*)> moveCtor;
+      void* (*getOrAdd)(Entity&) = nullptr;
+      void* (*tryGet)(Entity&) = nullptr;
+      const void* (*tryGetConst)(const Entity&) = nullptr; // todo: remove?
 
-      std::function<bool (const Entity&)> has;
-      std::function<void* (Entity&)> add;
-      std::function<void (Entity&)> remove;
-      std::function<void* (Entity&)> get; // todo: remove?
+      void (*duplicate)(void*, const void*) = nullptr; // todo: remove
 
-      std::function<void* (Entity&)> getOrAdd;
-      std::function<void* (Entity&)> tryGet;
-      std::function<const void* (const Entity&)> tryGetConst; // todo: remove?
+      void (*patch)(Entity&) = nullptr;
+      void (*onChanged)(void*) = nullptr; // todo: remove?
+   };
+
+   // components of entity by ComponentInfo::index
+   struct ComponentMask {
+      static constexpr u32 MaxComponents = 128;
 
-      std::function<void(void*, const void*)> duplicate; // todo: remove
+      void Set(u32 idx) {
+         ASSERT(idx < MaxComponents);
+         words[idx / 64] |= 1ull << (idx % 64);
+      }
+      bool Test(u32 idx) const {
+         ASSERT(idx < MaxComponents);
+         return words[idx / 64] & (1ull << (idx % 64));
+      }
 
-      std::function<void (Entity&)> patch;
-      std::function<void(void*)> onChanged; // todo: remove?
+      // func(idx) for each component in increasing order
+      template<typename Func>
+      void ForEach(Func&& func) const {
+         for (u32 i = 0; i < NWords; ++i) {
+            for (u64 bits = words[i]; bits; bits &= bits - 1) {
+               func(i * 64 + (u32)std::countr_zero(bits));
+            }
+         }
+      }
 
-      // todo:
-      // ComponentInfo() = default;
-      // ComponentInfo(ComponentInfo&&) = default;
-      // ONLY_MOVE(ComponentInfo);
+   private:
+      static constexpr u32 NWords = MaxComponents / 64;
+      u64 words[NWords] = {};
    };
 
    struct ScriptInfo {
@@ -116,10 +203,29 @@ namespace pbe {
       }
       TypeInfo& GetTypeInfo(TypeID typeID);
 
+      // after Finalize, indices are invalid once any type is registered or unregistered until next Finalize
+      const TypeInfo& GetTypeInfoByIndex(u32 index) const {
+         ASSERT_MESSAGE(finalized, "Typer::Finalize must be called after types registration");
+         return *typesByIndex[index];
+      }
+      const ComponentInfo* FindComponent(std::string_view name) const;
+      ComponentMask GetComponentMask(const Entity& entity) const;
+
       bool UI(std::string_view name, TypeID typeID, u8* value) const;
+      bool UI(std::string_view name, const TypeInfo& ti, u8* value) const;
+
       void Serialize(Serializer& ser, std::string_view name, TypeID typeID, const u8* value) const;
+      void Serialize(Serializer& ser, std::string_view name, const TypeInfo& ti, const u8* value) const;
       bool Deserialize(const Deserializer& deser, std::string_view name, TypeID typeID, u8* value) const;
+      bool Deserialize(const Deserializer& deser, std::string_view name, const TypeInfo& ti, u8* value) const;
 
+      // binary form: custom serializeBin, pod bytes, yaml text for types with only custom yaml serialize, fields
+      void SerializeBin(BinaryWriter& writer, TypeID typeID, const u8* value) const;
+      void SerializeBin(BinaryWriter& writer, const TypeInfo& ti, const u8* value) const;
+      bool DeserializeBin(BinaryReader& reader, TypeID typeID, u8* value) const;
+      bool DeserializeBin(BinaryReader& reader, const TypeInfo& ti, u8* value) const;
+
+      // assigns dense indices and builds lookup tables, call after types are registered or unregistered
       void Finalize();
 
       std::unordered_map<TypeID, TypeInfo> types;
@@ -128,7 +234,21 @@ namespace pbe {
       std::vector<ScriptInfo> scripts;
 
    private:
+      std::vector<TypeInfo*> typesByIndex;
+      std::unordered_map<std::string_view, u32> componentIndices; // by type name
+      std::unordered_map<TypeID, u32> componentIndicesByStorage; // by entt storage id, same as TypeID
+      bool finalized = false;
+
+      // tables point to registered types, dropped until next Finalize
+      void InvalidateTables();
+
+      // by index if tables are valid, nested types are resolved without hashing
+      const TypeInfo& GetTypeInfo(TypeID typeID, u32 typeIndex) const {
+         return finalized ? *typesByIndex[typeIndex] : types.at(typeID);
+      }
+
       void ProcessType(TypeInfo& ti, std::unordered_set<TypeID>& processedTypeIDs);
+      void BuildBinaryOps(TypeInfo& ti);
    };
 
 }
@@ -2,6 +2,8 @@
 
 #include <vector>
 
+#include "core/Core.h"
+
 namespace pbe {
 
    template<typename T>
@@ -21,4 +23,37 @@ namespace pbe {
       }
    }
 
+   // LSD radix sort by 8 bit digits. Sorts only low 'nBits' of keys, values are permuted with keys
+   template<typename Key, typename Value>
+   void RadixSort(std::vector<Key>& keys, std::vector<Value>& values, u32 nBits = sizeof(Key) * 8) {
+      static_assert(std::is_unsigned_v<Key>);
+
+      size_t size = keys.size();
+      std::vector<Key> keysTmp(size);
+      std::vector<Value> valuesTmp(size);
+
+      for (u32 shift = 0; shift < nBits; shift += 8) {
+         u32 offsets[256] = {};
+         for (auto key : keys) {
+            offsets[(key >> shift) & 0xFF]++;
+         }
+
+         u32 sum = 0;
+         for (auto& offset : offsets) {
+            u32 count = offset;
+            offset = sum;
+            sum += count;
+         }
+
+         for (size_t i = 0; i < size; ++i) {
+            u32 dst = offsets[(keys[i] >> shift) & 0xFF]++;
+            keysTmp[dst] = keys[i];
+            valuesTmp[dst] = std::move(values[i]);
+         }
+
+         std::swap(keys, keysTmp);
+         std::swap(values, valuesTmp);
+      }
+   }
+
 }
@@ -1,8 +1,205 @@
 #pragma once
+#include <string_view>
+#include <cstring>
+#include <type_traits>
+
 #include "core/Core.h"
 
+#if defined(_MSC_VER)
+   #include <intrin.h>
+#endif
+
 namespace pbe {
 
+   namespace hash_detail {
+      // wyhash final4 (public domain, https://github.com/wangyi-fudan/wyhash), constexpr for compile time strings
+      constexpr u64 Secret[4] = { 0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull };
+
+      // 64x64 -> 128 multiply, a = low, b = high
+      constexpr void Mum(u64& a, u64& b) {
+         if (!std::is_constant_evaluated()) {
+#if defined(_MSC_VER) && defined(_M_X64)
+            a = _umul128(a, b, &b);
+            return;
+#elif defined(__SIZEOF_INT128__)
+            __uint128_t r = (__uint128_t)a * b;
+            a = (u64)r;
+            b = (u64)(r >> 64);
+            return;
+#endif
+         }
+
+         u64 ha = a >> 32, hb = b >> 32, la = (u32)a, lb = (u32)b;
+         u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+         u64 t = rl + (rm0 << 32);
+         u64 c = t < rl;
+         u64 lo = t + (rm1 << 32);
+         c += lo < t;
+         a = lo;
+         b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+      }
+
+      constexpr u64 Mix(u64 a, u64 b) {
+         Mum(a, b);
+         return a ^ b;
+      }
+
+      // little endian reads
+      template<typename T>
+      constexpr T Read(const char* p) {
+         if (!std::is_constant_evaluated()) {
+            T v;
+            memcpy(&v, p, sizeof(T));
+            return v;
+         }
+
+         T v = 0;
+         for (u32 i = 0; i < sizeof(T); ++i) {
+            v |= T((u8)p[i]) << (8 * i);
+         }
+         return v;
+      }
+
+      constexpr u64 Read8(const char* p) { return Read<u64>(p); }
+      constexpr u64 Read4(const char* p) { return Read<u32>(p); }
+      constexpr u64 Read3(const char* p, size_t k) {
+         return (u64((u8)p[0]) << 16) | (u64((u8)p[k >> 1]) << 8) | (u8)p[k - 1];
+      }
+
+      constexpr u64 WyHash(const char* p, size_t len, u64 seed) {
+         seed ^= Mix(seed ^ Secret[0], Secret[1]);
+
+         u64 a = 0;
+         u64 b = 0;
+         if (len <= 16) {
+            if (len >= 4) {
+               size_t off = (len >> 3) << 2;
+               a = (Read4(p) << 32) | Read4(p + off);
+               b = (Read4(p + len - 4) << 32) | Read4(p + len - 4 - off);
+            } else if (len > 0) {
+               a = Read3(p, len);
+            }
+         } else {
+            size_t i = len;
+            if (i > 48) {
+               u64 see1 = seed;
+               u64 see2 = seed;
+               do {
+                  seed = Mix(Read8(p) ^ Secret[1], Read8(p + 8) ^ seed);
+                  see1 = Mix(Read8(p + 16) ^ Secret[2], Read8(p + 24) ^ see1);
+                  see2 = Mix(Read8(p + 32) ^ Secret[3], Read8(p + 40) ^ see2);
+                  p += 48;
+                  i -= 48;
+               } while (i > 48);
+               seed ^= see1 ^ see2;
+            }
+            while (i > 16) {
+               seed = Mix(Read8(p) ^ Secret[1], Read8(p + 8) ^ seed);
+               i -= 16;
+               p += 16;
+            }
+            a = Read8(p + i - 16);
+            b = Read8(p + i - 8);
+         }
+
+         a ^= Secret[1];
+         b ^= seed;
+         Mum(a, b);
+         return Mix(a ^ Secret[0] ^ len, b ^ Secret[1]);
+      }
+   }
+
+   // strong 64 bit string hash, same result at compile time and runtime
+   constexpr u64 HashStr(std::string_view str, u64 seed = 0) {
+      return hash_detail::WyHash(str.data(), str.size(), seed);
+   }
+
+   // 64 bit wyhash of memory block
+   inline u64 HashMemory(const void* data, size_t size, u64 seed = 0) {
+      return hash_detail::WyHash((const char*)data, size, seed);
+   }
+
+   struct Hash128 {
+      u64 lo = 0;
+      u64 hi = 0;
+
+      bool operator==(const Hash128& rhs) const = default;
+   };
+
+   // streaming hash of composite data. Two independent lanes are mixed per 16 bytes (multiplies run in parallel),
+   // 128 bit result is used where collision means wrong object, e.g. cache keys.
+   // Add hashes object bytes including padding and pointers by address
+   class Hasher {
+   public:
+      explicit Hasher(u64 seed = 0)
+         : lane0(seed ^ hash_detail::Mix(seed ^ hash_detail::Secret[0], hash_detail::Secret[1]))
+         , lane1(seed ^ hash_detail::Mix(seed ^ hash_detail::Secret[2], hash_detail::Secret[3])) {}
+
+      void AddMemory(const void* data, size_t size) {
+         using namespace hash_detail;
+
+         const char* p = (const char*)data;
+         length += size;
+
+         if (size <= 16) {
+            u64 a = 0;
+            u64 b = 0;
+            if (size >= 4) {
+               size_t off = (size >> 3) << 2;
+               a = (Read4(p) << 32) | Read4(p + off);
+               b = (Read4(p + size - 4) << 32) | Read4(p + size - 4 - off);
+            } else if (size > 0) {
+               a = Read3(p, size);
+            }
+            Mix16(a ^ size, b);
+            return;
+         }
+
+         size_t i = size;
+         while (i > 16) {
+            Mix16(Read8(p), Read8(p + 8));
+            p += 16;
+            i -= 16;
+         }
+         // last 16 bytes, may overlap previous chunk
+         Mix16(Read8(p + i - 16) ^ size, Read8(p + i - 8));
+      }
+
+      template<typename T> requires std::is_trivially_copyable_v<T>
+      void Add(const T& v) {
+         AddMemory(&v, sizeof(T));
+      }
+
+      void Add(std::string_view str) {
+         AddMemory(str.data(), str.size());
+      }
+
+      void Add(std::wstring_view str) {
+         AddMemory(str.data(), str.size() * sizeof(wchar_t));
+      }
+
+      Hash128 Get128() const {
+         using namespace hash_detail;
+         return { Mix(lane0 ^ Secret[0], length ^ Secret[1]), Mix(lane1 ^ Secret[2], length ^ Secret[3]) };
+      }
+
+      u64 Get() const {
+         using namespace hash_detail;
+         return Mix(lane0 ^ Secret[0], lane1 ^ length ^ Secret[1]);
+      }
+
+   private:
+      u64 lane0;
+      u64 lane1;
+      u64 length = 0;
+
+      void Mix16(u64 a, u64 b) {
+         using namespace hash_detail;
+         lane0 = Mix(a ^ Secret[1], b ^ lane0);
+         lane1 = Mix(b ^ Secret[2], a ^ lane1);
+      }
+   };
+
    // https://stackoverflow.com/questions/19195183/how-to-properly-hash-the-custom-struct
    template <class T>
    void HashCombine(std::size_t& seed, const T& v) {
@@ -10,22 +207,24 @@ namespace pbe {
       seed ^= hasher(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
    }
 
-   template <class T>
-   void HashCombineMemoryInternal(std::size_t& seed, const T* data, u32& dataSizeInBytes) {
-      constexpr int stepSize = sizeof(T);
-
-      while (dataSizeInBytes >= stepSize) {
-         HashCombine(seed, *(T*)data);
-         data = data + 1;
-         dataSizeInBytes -= stepSize;
-      }
+   inline void HashCombineMemory(std::size_t& seed, const void* data, size_t dataSizeInBytes) {
+      HashCombine(seed, HashMemory(data, dataSizeInBytes));
    }
 
-   void HashCombineMemory(std::size_t& seed, const void* data, u32 dataSizeInBytes);
-
    template <class T>
    void HashCombineMemory(std::size_t& seed, const T& data) {
       HashCombineMemory(seed, &data, sizeof(T));
    }
-   
+
+}
+
+namespace std {
+
+   template <>
+   struct hash<pbe::Hash128> {
+      std::size_t operator()(const pbe::Hash128& h) const {
+         return (std::size_t)h.lo;
+      }
+   };
+
 }
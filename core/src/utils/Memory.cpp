@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "Memory.h"
+#include "math/Common.h"
+
+namespace pbe {
+
+   static constexpr size_t BlockAlign = 64;
+
+   LinearArena::LinearArena(size_t blockSize) : blockSize(blockSize) {
+   }
+
+   LinearArena::~LinearArena() {
+      for (auto& block : blocks) {
+         ::operator delete(block.data, std::align_val_t{ BlockAlign });
+      }
+   }
+
+   void* LinearArena::Alloc(size_t size, size_t align) {
+      if (!blocks.empty()) {
+         size_t begin = AlignUp(offset, align);
+         if (begin + size <= blocks.back().size) {
+            offset = begin + size;
+            return blocks.back().data + begin;
+         }
+         usedBefore += offset;
+      }
+
+      // grow geometrically, big allocations get own block
+      size_t newBlockSize = std::max(blockSize, AlignUp(size, BlockAlign) + std::max(align, BlockAlign));
+      if (!blocks.empty()) {
+         newBlockSize = std::max(newBlockSize, blocks.back().size * 2);
+      }
+
+      Block block;
+      block.data = (u8*)::operator new(newBlockSize, std::align_val_t{ BlockAlign });
+      block.size = newBlockSize;
+      blocks.push_back(block);
+
+      size_t begin = AlignUp((size_t)block.data, align) - (size_t)block.data;
+      offset = begin + size;
+      return block.data + begin;
+   }
+
+   void LinearArena::Reset() {
+      if (blocks.size() > 1) {
+         size_t totalSize = Capacity();
+         for (auto& block : blocks) {
+            ::operator delete(block.data, std::align_val_t{ BlockAlign });
+         }
+         blocks.clear();
+
+         Block block;
+         block.data = (u8*)::operator new(totalSize, std::align_val_t{ BlockAlign });
+         block.size = totalSize;
+         blocks.push_back(block);
+      }
+
+      offset = 0;
+      usedBefore = 0;
+   }
+
+   size_t LinearArena::Capacity() const {
+      size_t capacity = 0;
+      for (const auto& block : blocks) {
+         capacity += block.size;
+      }
+      return capacity;
+   }
+
+   static std::atomic<u64> sFrameIdx = 0;
+
+   // arena is reset by owning thread on first allocation in new frame, no sync with other threads
+   struct ThreadFrameArenas {
+      LinearArena arenas[FrameArena::NFrames];
+      u64 arenaFrame[FrameArena::NFrames] = {};
+   };
+
+   static thread_local ThreadFrameArenas tFrameArenas;
+
+   void* FrameArena::Alloc(size_t size, size_t align) {
+      u64 frameIdx = sFrameIdx.load(std::memory_order_relaxed);
+      u32 slot = u32(frameIdx % NFrames);
+
+      auto& arena = tFrameArenas.arenas[slot];
+      if (tFrameArenas.arenaFrame[slot] != frameIdx) {
+         tFrameArenas.arenaFrame[slot] = frameIdx;
+         arena.Reset();
+      }
+
+      return arena.Alloc(size, align);
+   }
+
+   void FrameArena::NextFrame() {
+      sFrameIdx.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   u64 FrameArena::FrameIdx() {
+      return sFrameIdx.load(std::memory_order_relaxed);
+   }
+
+}
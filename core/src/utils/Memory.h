@@ -1,5 +1,6 @@
 #pragma once
 #include "core/Core.h"
+#include "core/Common.h"
 
 namespace pbe {
 #define KB (1024)
@@ -15,4 +16,68 @@ namespace pbe {
    void MemsetZero(T& data) {
       Memset(data, 0);
    }
+
+   // bump allocator, memory is released all at once by Reset
+   class CORE_API LinearArena {
+   public:
+      NON_COPYABLE(LinearArena);
+
+      LinearArena(size_t blockSize = 64 * KB);
+      ~LinearArena();
+
+      void* Alloc(size_t size, size_t align);
+
+      // blocks are merged into one, so same amount of allocations next time doesn't touch heap
+      void Reset();
+
+      size_t Used() const { return usedBefore + offset; }
+      size_t Capacity() const;
+
+   private:
+      struct Block {
+         u8* data = nullptr;
+         size_t size = 0;
+      };
+
+      std::vector<Block> blocks;
+      size_t blockSize;
+      size_t offset = 0; // in last block
+      size_t usedBefore = 0; // in previous blocks
+   };
+
+   // transient memory for data built and consumed during frame. Each thread allocates from own arena
+   // without locks, arena of frame is reused NFrames frames later, so data may live until next frames
+   class CORE_API FrameArena {
+   public:
+      static constexpr u32 NFrames = 3;
+
+      static void* Alloc(size_t size, size_t align);
+
+      // main thread, before frame update
+      static void NextFrame();
+      static u64 FrameIdx();
+   };
+
+   // stl allocator over FrameArena, deallocate does nothing. Reserve containers when size is known,
+   // reallocation leaves previous storage in arena until frame reuse
+   template<typename T>
+   struct FrameAllocator {
+      using value_type = T;
+
+      FrameAllocator() = default;
+      template<typename U>
+      FrameAllocator(const FrameAllocator<U>&) {}
+
+      T* allocate(size_t n) {
+         return (T*)FrameArena::Alloc(n * sizeof(T), alignof(T));
+      }
+
+      void deallocate(T*, size_t) {}
+
+      template<typename U>
+      bool operator==(const FrameAllocator<U>&) const { return true; }
+   };
+
+   template<typename T>
+   using FrameVector = std::vector<T, FrameAllocator<T>>;
 }
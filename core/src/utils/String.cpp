@@ -13,8 +13,4 @@ namespace pbe {
       std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
       return converter.to_bytes(wstring);
    }
-
-   size_t StrHash(std::string_view str) {
-      return std::hash<std::string_view>()(str);
-   }
 }
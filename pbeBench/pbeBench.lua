@@ -0,0 +1,12 @@
+project "pbeBench"
+   consoleCppApp()
+
+   files { "**.h", "**.cpp" }
+
+   pchheader "pch.h"
+   pchsource "src/pch.cpp"
+
+   includedirs(libsinfo.core.includedirs)
+   includedirs("src")
+
+   linkCoreHeadless()
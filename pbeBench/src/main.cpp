@@ -0,0 +1,440 @@
+#include "pch.h"
+#include "app/Application.h"
+#include "app/EntryPoint.h"
+#include "app/Layer.h"
+#include "core/CpuTrace.h"
+#include "core/Log.h"
+#include "core/MemoryTracker.h"
+#include "core/Profiler.h"
+#include "fs/FileSystem.h"
+#include "rend/BVH.h"
+#include "rend/RefPathTracer.h"
+#include "scene/Component.h"
+#include "scene/Entity.h"
+#include "scene/Scene.h"
+
+
+namespace pbe {
+
+   // PROFILE_CPU scopes inside scene update, merged by profiler at start of next frame
+   static const char* sProfiledPhases[] = {
+      "Scene sync",
+      "Phys simulate",
+      "Scripts update",
+      "Update world transforms",
+   };
+
+   struct BenchDesc {
+      u32 nFrames = 300;
+      u32 nWarmupFrames = 10; // not included in stats
+      string assetsPath = "../../assets";
+      string outPath = "bench.csv"; // .json or .csv
+      string tracePath; // chrome trace of measured frames per scene, <path>_<scene>.json
+      std::vector<string> scenes; // all scenes from assetsPath if empty
+
+      // cpu reference path tracing instead of simulation bench
+      string refTraceScene;
+      string refTraceOutPath = "reftrace.pfm";
+      string refPath; // compared with rendered image if set
+      u32 refTraceSpp = 16;
+   };
+
+   struct PhaseStats {
+      string name;
+      std::vector<float> samplesMs;
+
+      float Mean() const {
+         float sum = 0;
+         for (float s : samplesMs) {
+            sum += s;
+         }
+         return samplesMs.empty() ? 0 : sum / (float)samplesMs.size();
+      }
+
+      // nearest rank, samples must be sorted
+      float Percentile(float p) const {
+         if (samplesMs.empty()) {
+            return 0;
+         }
+         u32 idx = (u32)std::ceil(p / 100.f * (float)samplesMs.size());
+         return samplesMs[std::clamp(idx, 1u, (u32)samplesMs.size()) - 1];
+      }
+   };
+
+   // heap allocations of measured frames, only with memory tracking
+   struct MemoryResult {
+      u32 nFrames = 0;
+      u64 nAllocs = 0;
+      u64 allocatedBytes = 0;
+      u64 maxFrameAllocs = 0;
+      u64 liveBytes = 0; // after last measured frame
+      u64 tagAllocs[(u32)MemoryTag::Count] = {};
+
+      double AllocsPerFrame() const { return nFrames > 0 ? double(nAllocs) / nFrames : 0; }
+      double BytesPerFrame() const { return nFrames > 0 ? double(allocatedBytes) / nFrames : 0; }
+   };
+
+   struct SceneResult {
+      string scene;
+      u32 nEntities = 0;
+      std::vector<PhaseStats> phases;
+      MemoryResult memory;
+   };
+
+   // loads scenes one by one and simulates them for fixed number of frames
+   class BenchLayer : public Layer {
+   public:
+      BenchLayer(const BenchDesc& desc) : Layer("BenchLayer"), desc(desc) {
+         scenes = desc.scenes;
+         if (scenes.empty()) {
+            std::error_code ec;
+            if (!fs::is_directory(desc.assetsPath, ec)) {
+               WARN("Bench assets path '{}' is not a directory", desc.assetsPath);
+            } else {
+               for (auto& file : fs::directory_iterator(desc.assetsPath, ec)) {
+                  if (file.path().extension() == ".scn" || file.path().extension() == ".scnb") {
+                     scenes.push_back(file.path().string());
+                  }
+               }
+               std::ranges::sort(scenes);
+            }
+         }
+
+         // nothing to do, app quits on first update
+         if (scenes.empty()) {
+            WARN("No scenes to bench");
+         }
+      }
+
+      void OnDetach() override {
+         UnloadScene();
+         WriteResults();
+      }
+
+      void OnUpdate(float dt) override {
+         if (recordProfiled) {
+            RecordProfiledPhases();
+            recordProfiled = false;
+         }
+
+         if (scene && frameIdx == desc.nWarmupFrames + desc.nFrames) {
+            UnloadScene();
+         }
+
+         if (!scene) {
+            if (sceneIdx == scenes.size()) {
+               sApplication->Quit();
+               return;
+            }
+            LoadScene(scenes[sceneIdx++]);
+            return;
+         }
+
+         SimulateFrame(dt);
+         recordProfiled = frameIdx >= desc.nWarmupFrames;
+         ++frameIdx;
+      }
+
+   private:
+      BenchDesc desc;
+      std::vector<string> scenes;
+      u32 sceneIdx = 0;
+
+      Own<Scene> scene;
+      u32 frameIdx = 0;
+      bool recordProfiled = false;
+
+      std::vector<SRTObject> rtObjs;
+      std::vector<AABB> rtAabbs;
+      BVH bvh;
+
+      std::vector<SceneResult> results;
+
+      void LoadScene(const string& path) {
+         auto& result = results.emplace_back();
+         result.scene = fs::path(path).filename().string();
+
+         CpuTimer timer;
+         scene = SceneDeserialize(path);
+         float deserializeMs = timer.ElapsedMs();
+
+         if (!scene) {
+            results.pop_back();
+            return;
+         }
+
+         result.nEntities = scene->EntitiesCount();
+         result.phases.push_back({ .name = "Deserialize", .samplesMs = { deserializeMs } });
+         for (const char* phase : sProfiledPhases) {
+            result.phases.push_back({ .name = phase, .samplesMs = {} });
+         }
+         result.phases.push_back({ .name = "BVH build", .samplesMs = {} });
+         result.phases.push_back({ .name = "Frame", .samplesMs = {} });
+
+         scene->OnStart();
+         frameIdx = 0;
+
+         INFO("Bench scene '{}', {} entities", result.scene, result.nEntities);
+      }
+
+      void UnloadScene() {
+         if (!scene) {
+            return;
+         }
+
+         if (!desc.tracePath.empty()) {
+            fs::path tracePath = desc.tracePath;
+            tracePath.replace_filename(tracePath.stem().string() + "_" + fs::path(results.back().scene).stem().string() + ".json");
+            // unloaded one frame after last measured one
+            CpuTrace::Dump(tracePath.string(), desc.nFrames + 1);
+         }
+
+         scene->OnStop();
+         scene = {};
+
+         for (auto& phase : results.back().phases) {
+            std::ranges::sort(phase.samplesMs);
+         }
+      }
+
+      void SimulateFrame(float dt) {
+         CpuTimer frameTimer;
+
+         scene->OnTick();
+         scene->OnUpdate(dt);
+
+         CpuTimer bvhTimer;
+         GatherRTObjects(*scene, rtObjs, rtAabbs);
+         bvh.Build(rtAabbs, BVH::SplitMethod::BinnedSAH);
+         bvh.Flatten();
+         float bvhMs = bvhTimer.ElapsedMs();
+
+         float frameMs = frameTimer.ElapsedMs();
+
+         if (frameIdx < desc.nWarmupFrames) {
+            return;
+         }
+
+         auto& phases = results.back().phases;
+         phases[1 + std::size(sProfiledPhases)].samplesMs.push_back(bvhMs);
+         phases[2 + std::size(sProfiledPhases)].samplesMs.push_back(frameMs);
+      }
+
+      // profiler merged previous frame in NextFrame before layers update
+      void RecordProfiledPhases() {
+         auto& profiler = Profiler::Get();
+         auto& phases = results.back().phases;
+
+         for (u32 i = 0; i < std::size(sProfiledPhases); ++i) {
+            auto event = profiler.FindCpuEvent(sProfiledPhases[i]);
+            bool used = event && event->usedInFrame;
+            phases[1 + i].samplesMs.push_back(used ? event->elapsedMsCur : 0.f);
+         }
+
+         const auto& memStats = MemoryTracker::GetStats();
+         auto& memory = results.back().memory;
+
+         ++memory.nFrames;
+         memory.nAllocs += memStats.frameAllocs;
+         memory.allocatedBytes += memStats.frameBytes;
+         memory.maxFrameAllocs = std::max(memory.maxFrameAllocs, memStats.frameAllocs);
+         memory.liveBytes = memStats.liveBytes;
+         for (u32 i = 0; i < (u32)MemoryTag::Count; ++i) {
+            memory.tagAllocs[i] += memStats.tags[i].frameAllocs;
+         }
+      }
+
+      void WriteResults() const {
+         for (const auto& result : results) {
+            INFO("{} ({} entities)", result.scene, result.nEntities);
+            for (const auto& phase : result.phases) {
+               INFO("   {:<24} mean {:8.3f} ms  p50 {:8.3f} ms  p95 {:8.3f} ms  p99 {:8.3f} ms",
+                  phase.name, phase.Mean(), phase.Percentile(50), phase.Percentile(95), phase.Percentile(99));
+            }
+
+            if (MemoryTracker::IsEnabled()) {
+               const auto& memory = result.memory;
+               INFO("   {:<24} mean {:8.1f}  max {:6}  {:8.1f} KB/frame  live {:.2f} MB", "Allocations per frame",
+                  memory.AllocsPerFrame(), memory.maxFrameAllocs, memory.BytesPerFrame() / 1024., memory.liveBytes / (1024. * 1024.));
+               for (u32 i = 0; i < (u32)MemoryTag::Count; ++i) {
+                  if (memory.tagAllocs[i] > 0) {
+                     INFO("      {:<21} mean {:8.1f}", MemoryTagName((MemoryTag)i), double(memory.tagAllocs[i]) / memory.nFrames);
+                  }
+               }
+            }
+         }
+
+         if (results.empty()) {
+            WARN("No scenes were benched, '{}' is not written", desc.outPath);
+            return;
+         }
+
+         std::ofstream out{ desc.outPath };
+         if (!out) {
+            WARN("Can't open '{}' for bench results", desc.outPath);
+            return;
+         }
+
+         if (fs::path(desc.outPath).extension() == ".json") {
+            out << "[\n";
+            for (size_t i = 0; i < results.size(); ++i) {
+               const auto& result = results[i];
+               out << "  {\"scene\": \"" << result.scene << "\", \"entities\": " << result.nEntities
+                   << ", \"frames\": " << desc.nFrames;
+               if (MemoryTracker::IsEnabled()) {
+                  const auto& memory = result.memory;
+                  out << ", \"allocsPerFrame\": " << memory.AllocsPerFrame() << ", \"maxAllocsPerFrame\": " << memory.maxFrameAllocs
+                      << ", \"allocBytesPerFrame\": " << memory.BytesPerFrame() << ", \"liveBytes\": " << memory.liveBytes;
+               }
+               out << ", \"phases\": [\n";
+               for (size_t j = 0; j < result.phases.size(); ++j) {
+                  const auto& phase = result.phases[j];
+                  out << "    {\"name\": \"" << phase.name << "\", \"mean\": " << phase.Mean()
+                      << ", \"p50\": " << phase.Percentile(50) << ", \"p95\": " << phase.Percentile(95) << ", \"p99\": " << phase.Percentile(99)
+                      << "}" << (j + 1 < result.phases.size() ? "," : "") << "\n";
+               }
+               out << "  ]}" << (i + 1 < results.size() ? "," : "") << "\n";
+            }
+            out << "]\n";
+         } else {
+            out << "scene,entities,phase,samples,mean_ms,p50_ms,p95_ms,p99_ms";
+            if (MemoryTracker::IsEnabled()) {
+               out << ",allocs_per_frame,max_allocs_per_frame,alloc_bytes_per_frame,live_bytes";
+            }
+            out << "\n";
+
+            for (const auto& result : results) {
+               for (const auto& phase : result.phases) {
+                  out << result.scene << "," << result.nEntities << "," << phase.name << ","
+                      << phase.samplesMs.size() << "," << phase.Mean() << ","
+                      << phase.Percentile(50) << "," << phase.Percentile(95) << "," << phase.Percentile(99);
+                  if (MemoryTracker::IsEnabled()) {
+                     const auto& memory = result.memory;
+                     out << "," << memory.AllocsPerFrame() << "," << memory.maxFrameAllocs << ","
+                         << memory.BytesPerFrame() << "," << memory.liveBytes;
+                  }
+                  out << "\n";
+               }
+            }
+         }
+
+         INFO("Bench results saved to '{}'", desc.outPath);
+      }
+   };
+
+   // renders scene from its camera on cpu, saves pfm and compares it with reference image
+   static void RunRefTrace(const BenchDesc& desc) {
+      Own<Scene> scene = SceneDeserialize(desc.refTraceScene);
+      if (!scene) {
+         WARN("Ref trace: can't load scene '{}'", desc.refTraceScene);
+         return;
+      }
+
+      RefPathTracer refTracer;
+      refTracer.SetScene(*scene);
+
+      RefPathTracer::Desc traceDesc;
+      traceDesc.nSamples = desc.refTraceSpp;
+
+      // same as ViewportWindow with scene camera, default camera otherwise
+      vec3 cameraPos{ 0, 2, -5 };
+      vec3 cameraForward = glm::normalize(-cameraPos);
+      if (Entity cameraEntity = Entity::GetAnyWithComponent<CameraComponent>(*scene)) {
+         auto& trans = cameraEntity.GetTransform();
+         cameraPos = trans.Position();
+         cameraForward = trans.Forward();
+      } else {
+         WARN("Ref trace: scene '{}' has no camera, default one is used", desc.refTraceScene);
+      }
+
+      mat4 view = glm::lookAt(cameraPos, cameraPos + cameraForward, vec3_Y);
+      mat4 projection = glm::perspectiveFov(90.f / 180 * PI, (float)traceDesc.size.x, (float)traceDesc.size.y, 0.1f, 1000.f);
+
+      auto stats = refTracer.Render(traceDesc, cameraPos, glm::inverse(projection * view));
+      refTracer.SavePFM(desc.refTraceOutPath);
+
+      INFO("Ref trace '{}': {} spp, {:.1f} ms, {:.2f} MRays/s, saved to '{}'",
+         desc.refTraceScene, traceDesc.nSamples, stats.elapsedMs, stats.MRaysPerSec(), desc.refTraceOutPath);
+
+      if (desc.refPath.empty()) {
+         return;
+      }
+
+      uint2 refSize;
+      std::vector<vec3> refImage;
+      if (!RefPathTracer::LoadPFM(desc.refPath, refSize, refImage)) {
+         return;
+      }
+
+      if (refSize != refTracer.size) {
+         WARN("Ref trace: reference '{}' is {}x{}, rendered image is {}x{}",
+            desc.refPath, refSize.x, refSize.y, refTracer.size.x, refTracer.size.y);
+         return;
+      }
+
+      INFO("Ref trace RMSE {:.6f} against '{}'", RefPathTracer::RMSE(refTracer.image, refImage), desc.refPath);
+   }
+
+   class BenchApplication : public Application {
+   public:
+      BenchApplication() {
+         headless.enabled = true;
+      }
+
+      // [scenes...] -frames <n> -warmup <n> -dt <seconds> -assets <dir> -out <path.csv|path.json> -trace <path>
+      // -reftrace <scene> -spp <n> -ref <path.pfm> -reftrace-out <path.pfm>
+      void ParseArgs(int nArgs, char** args) override {
+         for (int i = 1; i < nArgs; ++i) {
+            std::string_view arg = args[i];
+            bool hasValue = i + 1 < nArgs;
+
+            if (arg == "-frames" && hasValue) {
+               desc.nFrames = (u32)std::stoul(args[++i]);
+            } else if (arg == "-warmup" && hasValue) {
+               desc.nWarmupFrames = (u32)std::stoul(args[++i]);
+            } else if (arg == "-dt" && hasValue) {
+               headless.dt = std::stof(args[++i]);
+            } else if (arg == "-assets" && hasValue) {
+               desc.assetsPath = args[++i];
+            } else if (arg == "-out" && hasValue) {
+               desc.outPath = args[++i];
+            } else if (arg == "-trace" && hasValue) {
+               desc.tracePath = args[++i];
+            } else if (arg == "-reftrace" && hasValue) {
+               desc.refTraceScene = args[++i];
+            } else if (arg == "-reftrace-out" && hasValue) {
+               desc.refTraceOutPath = args[++i];
+            } else if (arg == "-spp" && hasValue) {
+               desc.refTraceSpp = (u32)std::stoul(args[++i]);
+            } else if (arg == "-ref" && hasValue) {
+               desc.refPath = args[++i];
+            } else if (arg.starts_with('-')) {
+               WARN("Unknown argument '{}'", arg);
+            } else {
+               desc.scenes.emplace_back(arg);
+            }
+         }
+      }
+
+      void OnInit() override {
+         Application::OnInit();
+
+         if (!desc.refTraceScene.empty()) {
+            RunRefTrace(desc);
+            Quit();
+            return;
+         }
+
+         PushLayer(new BenchLayer(desc));
+      }
+
+   private:
+      BenchDesc desc;
+   };
+
+}
+
+int main(int nArgs, char** args) {
+   pbe::BenchApplication* app = new pbe::BenchApplication();
+   return pbeMain(app, nArgs, args);
+}
@@ -0,0 +1 @@
+#include "pchDefault.h"
\ No newline at end of file
@@ -188,7 +188,7 @@ namespace pbe {
             }
 
             if (ImGui::MenuItem("Open Scene", nullptr, false, canChangeScene)) {
-               auto path = OpenFileDialog({ "Scene", "*.scn" });
+               auto path = OpenFileDialog({ "Scene", "*.scn;*.scnb" });
                if (!path.empty()) {
                   editorSettings.scenePath = path;
                   auto s = SceneDeserialize(editorSettings.scenePath);
@@ -205,7 +205,7 @@ namespace pbe {
 
             if (ImGui::MenuItem("Save Scene As", "Ctrl+Shift+S", false,
                canChangeScene && !!editorScene)) {
-               auto path = OpenFileDialog({ "Scene", "*.scn", true });
+               auto path = OpenFileDialog({ "Scene", "*.scn;*.scnb", true });
                if (!path.empty()) {
                   editorSettings.scenePath = path;
                   SceneSerialize(editorSettings.scenePath, *editorScene);
@@ -407,7 +407,7 @@ namespace pbe {
    }
 
    void EditorLayer::ReloadDll() {
-      auto loadDll = [&] {
+      auto loadLibrary = [&] {
          ASSERT(dllHandler == 0);
 
          string dllName = "testProj.dll"; // todo:
@@ -424,14 +424,18 @@ namespace pbe {
             dllHandler = LoadLibrary(dllName.data());
          }
 
-         // process new types
-         Typer::Get().Finalize();
-
          if (!dllHandler) {
             WARN("could not load the dynamic library testProj.dll");
          }
       };
 
+      auto loadDll = [&] {
+         loadLibrary();
+
+         // process new types. Also when dll is not loaded, types of unloaded dll were unregistered
+         Typer::Get().Finalize();
+      };
+
       if (dllHandler) {
          if (editorScene) {
             // todo: do it on RAM
@@ -113,6 +113,10 @@ namespace pbe {
    public:
       void OnInit() override {
          Application::OnInit();
+         if (IsHeadless()) {
+            // editor needs device, only -scene is simulated
+            return;
+         }
 
          EditorLayer* editor = new EditorLayer();
          editor->AddEditorWindow(new TestWindow("TestWindow"));
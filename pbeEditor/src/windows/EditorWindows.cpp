@@ -1,22 +1,79 @@
 #include "pch.h"
 #include "EditorWindows.h"
+#include "core/MemoryTracker.h"
 #include "core/Profiler.h"
 #include "gui/Gui.h"
 #include "rend/Shader.h"
 
 namespace pbe {
 
+   static void TimeSummaryUI(const char* name, const TimeStats& stats) {
+      TimeSummary summary = stats.Summarize();
+      ImGui::Text("  %s: %.2f ms (p50 %.2f, p95 %.2f, p99 %.2f, max %.2f)",
+         name, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+   }
+
+   static void TimeHistogramUI(const TimeHistogram& histogram) {
+      u32 first = TimeHistogram::NBuckets;
+      u32 last = 0;
+      for (u32 i = 0; i < TimeHistogram::NBuckets; ++i) {
+         if (histogram.BucketCount(i) > 0) {
+            first = std::min(first, i);
+            last = i;
+         }
+      }
+      if (first > last) {
+         return;
+      }
+
+      std::vector<float> counts;
+      for (u32 i = first; i <= last; ++i) {
+         counts.push_back((float)histogram.BucketCount(i));
+      }
+
+      string overlay = std::format("{:.2f} - {:.2f} ms, p99 {:.2f} ms", TimeHistogram::BucketBeginMs(first),
+         TimeHistogram::BucketEndMs(last), histogram.Percentile(99));
+      ImGui::PlotHistogram("##frame time histogram", counts.data(), (int)counts.size(), 0, overlay.c_str(),
+         0, FLT_MAX, ImVec2(0, 60));
+   }
+
+   static void MemoryUI() {
+      if (!MemoryTracker::IsEnabled()) {
+         ImGui::Text("Memory: tracking is disabled (premake --memtrack)");
+         return;
+      }
+
+      const auto& stats = MemoryTracker::GetStats();
+      ImGui::Text("Memory: %.2f MB live (peak %.2f MB), %llu allocations", stats.liveBytes / (1024.f * 1024.f),
+         stats.peakLiveBytes / (1024.f * 1024.f), (unsigned long long)stats.liveAllocs);
+      ImGui::Text("  per frame: %llu allocations, %.1f KB", (unsigned long long)stats.frameAllocs, stats.frameBytes / 1024.f);
+
+      for (u32 i = 0; i < (u32)MemoryTag::Count; ++i) {
+         const auto& tag = stats.tags[i];
+         if (tag.frameAllocs == 0 && tag.nOverBudgetFrames == 0) {
+            continue;
+         }
+
+         bool overBudget = tag.frameAllocs > tag.frameAllocsBudget;
+         ImGui::TextColored(overBudget ? ImVec4(1, 0.3f, 0.3f, 1) : ImGui::GetStyleColorVec4(ImGuiCol_Text),
+            "  %s: %llu allocations, %.1f KB", MemoryTagName((MemoryTag)i),
+            (unsigned long long)tag.frameAllocs, tag.frameBytes / 1024.f);
+      }
+   }
+
    void ProfilerWindow::OnWindowUI() {
       auto& profiler = Profiler::Get();
 
       ImGui::Text("Profiler Stats");
+      TimeSummaryUI("Frame", profiler.frameTime);
+      TimeHistogramUI(profiler.frameTime.Histogram());
+
       ImGui::Text("Cpu:");
-      for (const auto& [name, cpuEvent] : profiler.cpuEvents) {
+      for (const auto& cpuEvent : profiler.cpuEvents) {
          if (!cpuEvent.usedInFrame) {
             continue;
          }
-         // ImGui::Text("  %s: %.2f %.2f ms", cpuEvent.name.data(), cpuEvent.averageTime.GetAverage(), cpuEvent.averageTime.GetCur());
-         ImGui::Text("  %s: %.2f ms", cpuEvent.name.data(), cpuEvent.averageTime.GetAverage());
+         TimeSummaryUI(cpuEvent.name.data(), cpuEvent.stats);
       }
 
       ImGui::Text("Gpu:");
@@ -24,8 +81,21 @@ namespace pbe {
          if (!gpuEvent.usedInFrame) {
             continue;
          }
-         // ImGui::Text("  %s: %.2f %.2f ms", gpuEvent.name.data(), gpuEvent.averageTime.GetAverage(), gpuEvent.averageTime.GetCur());
-         ImGui::Text("  %s: %.2f ms", gpuEvent.name.data(), gpuEvent.averageTime.GetAverage());
+         TimeSummaryUI(gpuEvent.name.data(), gpuEvent.stats);
+      }
+
+      MemoryUI();
+
+      if (ImGui::TreeNode("Hitches", "Hitches: %llu", (unsigned long long)profiler.nHitches)) {
+         for (const auto& hitch : profiler.hitches | std::views::reverse) {
+            if (ImGui::TreeNode((void*)(uintptr_t)hitch.frameIdx, "Frame %llu: %.2f ms", (unsigned long long)hitch.frameIdx, hitch.frameMs)) {
+               for (const auto& [name, ms] : hitch.scopes) {
+                  ImGui::Text("%.*s: %.2f ms", (int)name.size(), name.data(), ms);
+               }
+               ImGui::TreePop();
+            }
+         }
+         ImGui::TreePop();
       }
    }
 
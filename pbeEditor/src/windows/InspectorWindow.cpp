@@ -63,11 +63,12 @@ namespace pbe {
          return result;
       };
 
+      auto componentMask = typer.GetComponentMask(entity);
+
       if (UI_POPUP("Add Component Popup")) {
          for (const auto& ci : typer.components) {
-            auto* pComponent = ci.tryGet(entity);
-            if (!pComponent) {
-               auto processedName = processComponentName(typer.GetTypeInfo(ci.typeID).name);
+            if (!componentMask.Test(ci.index)) {
+               auto processedName = processComponentName(typer.GetTypeInfoByIndex(ci.typeIndex).name);
                if (ImGui::MenuItem(processedName.data())) {
                   ci.getOrAdd(entity);
                   edited = true;
@@ -81,9 +82,10 @@ namespace pbe {
          edited |= EditorUI(entity.GetTransform());
       }
 
-      for (const auto& ci : typer.components) {
+      componentMask.ForEach([&](u32 componentIdx) {
+         const auto& ci = typer.components[componentIdx];
          if (auto* pComponent = ci.tryGet(entity)) {
-            const auto& ti = typer.GetTypeInfo(ci.typeID);
+            const auto& ti = typer.GetTypeInfoByIndex(ci.typeIndex);
 
             auto processedName = processComponentName(ti.name);
             ui::TreeNode treeNode{ processedName.c_str(), DefaultTreeNodeFlags() };
@@ -113,7 +115,7 @@ namespace pbe {
                }
             }
          }
-      }
+      });
 
       if (edited) {
          Undo::Get().PushSave();
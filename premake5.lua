@@ -6,6 +6,14 @@ workspace "pbEngine"
 
    characterset "ASCII"
 
+   newoption {
+      trigger = "memtrack",
+      description = "Count heap allocations with global operator new/delete hook",
+   }
+
+   filter "options:memtrack"
+      defines { "PBE_MEMORY_TRACKING" }
+
    filter "configurations:Debug"
       defines { "DEBUG" }
       symbols "On"
@@ -65,4 +73,5 @@ group ""
 
 include "core/core.lua"
 include "pbeEditor/pbeEditor.lua"
+include "pbeBench/pbeBench.lua"
 include "testProj/testProj.lua"